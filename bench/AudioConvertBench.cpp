@@ -0,0 +1,327 @@
+// Compares the shared AudioConversionEngine against one
+// appsrc ! audioconvert ! audioresample ! fakesink pipeline per source.
+//
+// usage: audio_convert_bench [sources=24] [seconds=10]
+//
+// Both paths take the same synthetic 10 ms blocks through an appsrc per
+// source and end in interleaved F32 @ 48 kHz buffers reaching a fakesink, so
+// the engine side also pays for the appsink/appsrc hops and the interleave
+// the app does. Wall time favours the GStreamer path on multi-core machines
+// (one streaming thread per pipeline), so CPU time is reported as well.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iterator>
+#include <vector>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/audio/audio.h>
+#include <gst/gst.h>
+#include "audio/AudioConversionEngine.h"
+
+namespace {
+
+struct SourceConfig {
+  SampleFormat format;
+  const char* gstFormat;
+  int channels;
+  int rate;
+};
+
+const SourceConfig kConfigs[] = {
+    {SampleFormat::S16, GST_AUDIO_NE(S16), 2, 44100},
+    {SampleFormat::S32, GST_AUDIO_NE(S32), 2, 48000},
+    {SampleFormat::F32, GST_AUDIO_NE(F32), 2, 96000},
+    {SampleFormat::S16, GST_AUDIO_NE(S16), 1, 44100},
+    {SampleFormat::F32, GST_AUDIO_NE(F32), 8, 96000},
+    {SampleFormat::S16, GST_AUDIO_NE(S16), 2, 48000},
+};
+
+template <typename T>
+void fillSine(std::vector<uint8_t>& bytes, size_t frames, int channels, int rate, double amp) {
+  bytes.resize(frames * channels * sizeof(T));
+  auto* out = reinterpret_cast<T*>(bytes.data());
+  for (size_t i = 0; i < frames; ++i) {
+    const double v = amp * std::sin(2.0 * 3.14159265358979 * 997.0 * static_cast<double>(i) / rate);
+    for (int c = 0; c < channels; ++c) out[i * channels + c] = static_cast<T>(v);
+  }
+}
+
+// One second of audio per source, replayed as 10 ms blocks.
+struct SourceData {
+  SourceConfig cfg;
+  size_t blockFrames;
+  std::vector<uint8_t> second;
+};
+
+SourceData makeSource(const SourceConfig& cfg) {
+  SourceData d{cfg, static_cast<size_t>(cfg.rate / 100), {}};
+  switch (cfg.format) {
+    case SampleFormat::S16: fillSine<int16_t>(d.second, cfg.rate, cfg.channels, cfg.rate, 16000.0); break;
+    case SampleFormat::S32: fillSine<int32_t>(d.second, cfg.rate, cfg.channels, cfg.rate, 1.0e9); break;
+    case SampleFormat::F32: fillSine<float>(d.second, cfg.rate, cfg.channels, cfg.rate, 0.5); break;
+    case SampleFormat::F64: fillSine<double>(d.second, cfg.rate, cfg.channels, cfg.rate, 0.5); break;
+    default: break;  // not in kConfigs
+  }
+  return d;
+}
+
+struct Timing {
+  double wallMs;
+  double cpuMs;
+  size_t framesOut;
+};
+
+GstCaps* inputCaps(const SourceConfig& cfg) {
+  GstCaps* caps = gst_caps_new_simple("audio/x-raw",
+                                      "format", G_TYPE_STRING, cfg.gstFormat,
+                                      "layout", G_TYPE_STRING, "interleaved",
+                                      "rate", G_TYPE_INT, cfg.rate,
+                                      "channels", G_TYPE_INT, cfg.channels,
+                                      nullptr);
+  if (cfg.channels > 2) {
+    gst_caps_set_simple(caps, "channel-mask", GST_TYPE_BITMASK, guint64(0), nullptr);
+  }
+  return caps;
+}
+
+GstPadProbeReturn countFrames(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+  GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+  if (buf) {
+    *static_cast<size_t*>(user_data) += gst_buffer_get_size(buf) / sizeof(float);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+// Counts the float samples reaching the element named "sink".
+void probeSink(GstElement* pipeline, size_t* samples) {
+  GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+  GstPad* pad = gst_element_get_static_pad(sink, "sink");
+  gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, countFrames, samples, nullptr);
+  gst_object_unref(pad);
+  gst_object_unref(sink);
+}
+
+GstElement* appSrcOf(GstElement* pipeline) {
+  return gst_bin_get_by_name(GST_BIN(pipeline), "src");
+}
+
+// Feeds every source's appsrc the same sequence of timestamped 10 ms blocks.
+void pushBlocks(const std::vector<SourceData>& sources, const std::vector<GstElement*>& srcs,
+                int seconds) {
+  for (int blk = 0; blk < seconds * 100; ++blk) {
+    for (size_t i = 0; i < sources.size(); ++i) {
+      const SourceData& s = sources[i];
+      AudioInputFormat fmt{s.cfg.format, s.cfg.channels, s.cfg.rate};
+      const size_t bytes = s.blockFrames * fmt.bytesPerFrame();
+      const size_t offset = static_cast<size_t>(blk % 100) * bytes;
+      GstBuffer* buf = gst_buffer_new_memdup(s.second.data() + offset, bytes);
+      GST_BUFFER_PTS(buf) = gst_util_uint64_scale(static_cast<guint64>(blk), GST_SECOND, 100);
+      GST_BUFFER_DURATION(buf) = GST_SECOND / 100;
+      gst_app_src_push_buffer(GST_APP_SRC(srcs[i]), buf);
+    }
+  }
+}
+
+void endAndWait(const std::vector<GstElement*>& srcs, const std::vector<GstElement*>& pipelines) {
+  for (GstElement* src : srcs) gst_app_src_end_of_stream(GST_APP_SRC(src));
+  for (GstElement* pipeline : pipelines) {
+    GstBus* bus = gst_element_get_bus(pipeline);
+    GstMessage* msg = gst_bus_timed_pop_filtered(
+        bus, GST_CLOCK_TIME_NONE, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    if (msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+      std::fprintf(stderr, "benchmark pipeline failed\n");
+    }
+    if (msg) gst_message_unref(msg);
+    gst_object_unref(bus);
+  }
+}
+
+void release(const std::vector<GstElement*>& srcs, const std::vector<GstElement*>& pipelines) {
+  for (GstElement* pipeline : pipelines) gst_element_set_state(pipeline, GST_STATE_NULL);
+  for (GstElement* src : srcs) gst_object_unref(src);
+  for (GstElement* pipeline : pipelines) gst_object_unref(pipeline);
+}
+
+// Mirrors the app's engine mode per source: appsrc ! appsink into the engine
+// (as the capture branch), engine output interleaved into GstBuffers and
+// pushed through appsrc ! fakesink (as the output branch).
+struct EngineChain {
+  AudioConversionEngine* engine;
+  int id;
+  AudioInputFormat format;
+  GstElement* outSrc;
+  size_t samplesOut;
+};
+
+GstFlowReturn onEngineInput(GstAppSink* sink, gpointer user_data) {
+  auto* c = static_cast<EngineChain*>(user_data);
+  GstSample* sample = gst_app_sink_pull_sample(sink);
+  if (!sample) return GST_FLOW_EOS;
+  GstBuffer* buf = gst_sample_get_buffer(sample);
+  GstMapInfo map;
+  if (buf && gst_buffer_map(buf, &map, GST_MAP_READ)) {
+    c->engine->push(c->id, c->format, map.data, map.size / c->format.bytesPerFrame(),
+                    GST_BUFFER_PTS(buf));
+    gst_buffer_unmap(buf, &map);
+  }
+  gst_sample_unref(sample);
+  return GST_FLOW_OK;
+}
+
+// Same work as PreviewPipeline::pushEngineOutput.
+void pushEngineOutput(GstElement* src, const float* const* planes, int channels, size_t frames,
+                      uint64_t ptsNs, uint64_t durationNs) {
+  GstBuffer* buf = gst_buffer_new_allocate(nullptr, frames * channels * sizeof(float), nullptr);
+  GstMapInfo map;
+  if (!gst_buffer_map(buf, &map, GST_MAP_WRITE)) {
+    gst_buffer_unref(buf);
+    return;
+  }
+  auto* out = reinterpret_cast<float*>(map.data);
+  for (size_t i = 0; i < frames; ++i) {
+    for (int c = 0; c < channels; ++c) {
+      out[i * channels + c] = planes[c][i];
+    }
+  }
+  gst_buffer_unmap(buf, &map);
+  if (ptsNs != AudioConversionEngine::kNoTimestamp) {
+    GST_BUFFER_PTS(buf) = ptsNs;
+    GST_BUFFER_DURATION(buf) = durationNs;
+  }
+  gst_app_src_push_buffer(GST_APP_SRC(src), buf);
+}
+
+Timing runEngine(const std::vector<SourceData>& sources, int seconds) {
+  AudioConversionEngine engine(48000);
+  std::vector<EngineChain> chains(sources.size());
+  std::vector<GstElement*> inSrcs, inPipelines, outSrcs, outPipelines;
+
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const SourceConfig& cfg = sources[i].cfg;
+    EngineChain& c = chains[i];
+    c.engine = &engine;
+    c.format = {cfg.format, cfg.channels, cfg.rate};
+    c.samplesOut = 0;
+
+    GstElement* in = gst_parse_launch(
+        "appsrc name=src format=time max-bytes=0 ! appsink name=engine_sink sync=false", nullptr);
+    GstElement* inSrc = appSrcOf(in);
+    GstCaps* caps = inputCaps(cfg);
+    gst_app_src_set_caps(GST_APP_SRC(inSrc), caps);
+    gst_caps_unref(caps);
+    GstElement* appsink = gst_bin_get_by_name(GST_BIN(in), "engine_sink");
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = onEngineInput;
+    gst_app_sink_set_callbacks(GST_APP_SINK(appsink), &callbacks, &c, nullptr);
+    gst_object_unref(appsink);
+
+    GstElement* out = gst_parse_launch(
+        "appsrc name=src format=time max-bytes=0 ! fakesink name=sink sync=false", nullptr);
+    c.outSrc = appSrcOf(out);
+    GstCaps* outCaps = gst_caps_new_simple("audio/x-raw",
+                                           "format", G_TYPE_STRING, GST_AUDIO_NE(F32),
+                                           "layout", G_TYPE_STRING, "interleaved",
+                                           "rate", G_TYPE_INT, engine.outputRate(),
+                                           "channels", G_TYPE_INT, cfg.channels,
+                                           nullptr);
+    gst_app_src_set_caps(GST_APP_SRC(c.outSrc), outCaps);
+    gst_caps_unref(outCaps);
+    probeSink(out, &c.samplesOut);
+
+    c.id = engine.addSource([src = c.outSrc](const float* const* planes, int channels,
+                                             size_t frames, uint64_t pts, uint64_t duration) {
+      pushEngineOutput(src, planes, channels, frames, pts, duration);
+    });
+
+    inSrcs.push_back(inSrc);
+    inPipelines.push_back(in);
+    outSrcs.push_back(c.outSrc);
+    outPipelines.push_back(out);
+    gst_element_set_state(out, GST_STATE_PLAYING);
+    gst_element_set_state(in, GST_STATE_PLAYING);
+  }
+
+  const auto wall0 = std::chrono::steady_clock::now();
+  const std::clock_t cpu0 = std::clock();
+  engine.start();
+  pushBlocks(sources, inSrcs, seconds);
+  endAndWait(inSrcs, inPipelines);
+  engine.stop();
+  engine.processPending();  // whatever was staged after the last period
+  endAndWait(outSrcs, outPipelines);
+  const std::clock_t cpu1 = std::clock();
+  const auto wall1 = std::chrono::steady_clock::now();
+
+  size_t framesOut = 0;
+  for (size_t i = 0; i < chains.size(); ++i) {
+    framesOut += chains[i].samplesOut / static_cast<size_t>(sources[i].cfg.channels);
+    engine.removeSource(chains[i].id);
+  }
+  release(inSrcs, inPipelines);
+  release(outSrcs, outPipelines);
+  return {std::chrono::duration<double, std::milli>(wall1 - wall0).count(),
+          1000.0 * static_cast<double>(cpu1 - cpu0) / CLOCKS_PER_SEC, framesOut};
+}
+
+Timing runPerSourceElements(const std::vector<SourceData>& sources, int seconds) {
+  std::vector<size_t> samplesOut(sources.size(), 0);
+  std::vector<GstElement*> srcs, pipelines;
+
+  for (size_t i = 0; i < sources.size(); ++i) {
+    GstElement* pipeline = gst_parse_launch(
+        "appsrc name=src format=time max-bytes=0 ! audioconvert ! audioresample ! "
+        "audio/x-raw,format=" GST_AUDIO_NE(F32) ",rate=48000 ! fakesink name=sink sync=false",
+        nullptr);
+    GstElement* src = appSrcOf(pipeline);
+    GstCaps* caps = inputCaps(sources[i].cfg);
+    gst_app_src_set_caps(GST_APP_SRC(src), caps);
+    gst_caps_unref(caps);
+    probeSink(pipeline, &samplesOut[i]);
+
+    srcs.push_back(src);
+    pipelines.push_back(pipeline);
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  }
+
+  const auto wall0 = std::chrono::steady_clock::now();
+  const std::clock_t cpu0 = std::clock();
+  pushBlocks(sources, srcs, seconds);
+  endAndWait(srcs, pipelines);
+  const std::clock_t cpu1 = std::clock();
+  const auto wall1 = std::chrono::steady_clock::now();
+
+  size_t framesOut = 0;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    framesOut += samplesOut[i] / static_cast<size_t>(sources[i].cfg.channels);
+  }
+  release(srcs, pipelines);
+  return {std::chrono::duration<double, std::milli>(wall1 - wall0).count(),
+          1000.0 * static_cast<double>(cpu1 - cpu0) / CLOCKS_PER_SEC, framesOut};
+}
+
+void report(const char* name, const Timing& t, int seconds, size_t sources) {
+  const double audioMs = 1000.0 * seconds * static_cast<double>(sources);
+  std::printf("%-22s wall %9.1f ms  cpu %9.1f ms  (%5.2f%% of real time)  frames out %zu\n",
+              name, t.wallMs, t.cpuMs, 100.0 * t.cpuMs / audioMs, t.framesOut);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gst_init(&argc, &argv);
+  const int numSources = argc > 1 ? std::atoi(argv[1]) : 24;
+  const int seconds = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  std::vector<SourceData> sources;
+  for (int i = 0; i < numSources; ++i) {
+    sources.push_back(makeSource(kConfigs[static_cast<size_t>(i) % std::size(kConfigs)]));
+  }
+
+  std::printf("%d sources, %d s of audio each, 10 ms blocks -> F32 @ 48 kHz\n", numSources, seconds);
+  report("shared engine", runEngine(sources, seconds), seconds, sources.size());
+  report("per-source elements", runPerSourceElements(sources, seconds), seconds, sources.size());
+  return 0;
+}
@@ -0,0 +1,344 @@
+#include "AudioConversionEngine.h"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include "trace/Trace.h"
+
+namespace {
+
+template <typename T, bool Swap>
+T load(const uint8_t* p) {
+  T v;
+  if constexpr (Swap) {
+    uint8_t b[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); ++i) b[i] = p[sizeof(T) - 1 - i];
+    std::memcpy(&v, b, sizeof(T));
+  } else {
+    std::memcpy(&v, p, sizeof(T));
+  }
+  return v;
+}
+
+// Sample readers: kBytes per sample, read() returns it scaled to [-1, 1).
+struct U8Reader {
+  static constexpr size_t kBytes = 1;
+  static float read(const uint8_t* p) { return static_cast<float>(p[0] - 128) * (1.f / 128.f); }
+};
+
+template <typename T, bool Swap>
+struct IntReader {
+  static constexpr size_t kBytes = sizeof(T);
+  static float read(const uint8_t* p) {
+    constexpr float scale = 1.f / static_cast<float>(1ull << (8 * sizeof(T) - 1));
+    return static_cast<float>(load<T, Swap>(p)) * scale;
+  }
+};
+
+template <bool Swap>
+struct S24Reader {
+  static constexpr size_t kBytes = 3;
+  static float read(const uint8_t* p) {
+    constexpr bool little = (std::endian::native == std::endian::little) != Swap;
+    const uint32_t u = little ? (p[0] | p[1] << 8 | p[2] << 16) : (p[0] << 16 | p[1] << 8 | p[2]);
+    const int32_t v = static_cast<int32_t>(u ^ 0x800000u) - 0x800000;
+    return static_cast<float>(v) * (1.f / 8388608.f);
+  }
+};
+
+template <bool Swap>
+struct S24In32Reader {
+  static constexpr size_t kBytes = 4;
+  static float read(const uint8_t* p) {
+    // the top byte is padding and not necessarily a sign extension
+    const uint32_t u = static_cast<uint32_t>(load<int32_t, Swap>(p)) & 0xffffffu;
+    const int32_t v = static_cast<int32_t>(u ^ 0x800000u) - 0x800000;
+    return static_cast<float>(v) * (1.f / 8388608.f);
+  }
+};
+
+template <typename T, bool Swap>
+struct FloatReader {
+  static constexpr size_t kBytes = sizeof(T);
+  static float read(const uint8_t* p) { return static_cast<float>(load<T, Swap>(p)); }
+};
+
+template <bool Swap> using S16Reader = IntReader<int16_t, Swap>;
+template <bool Swap> using S32Reader = IntReader<int32_t, Swap>;
+template <bool Swap> using F32Reader = FloatReader<float, Swap>;
+template <bool Swap> using F64Reader = FloatReader<double, Swap>;
+
+// Deinterleaves and scales one sample type into per-channel float planes.
+// Frame-major so the input is read once, sequentially.
+template <typename Reader>
+void decode(const uint8_t* src, size_t frames, int channels,
+            std::vector<std::vector<float>>& planes) {
+  std::vector<float*> dst(static_cast<size_t>(channels));
+  for (int c = 0; c < channels; ++c) {
+    auto& plane = planes[static_cast<size_t>(c)];
+    const size_t old = plane.size();
+    plane.resize(old + frames);
+    dst[static_cast<size_t>(c)] = plane.data() + old;
+  }
+
+  constexpr size_t bps = Reader::kBytes;
+  const size_t stride = bps * static_cast<size_t>(channels);
+  if (channels == 2) {
+    float* __restrict l = dst[0];
+    float* __restrict r = dst[1];
+    for (size_t i = 0; i < frames; ++i) {
+      const uint8_t* frame = src + i * stride;
+      l[i] = Reader::read(frame);
+      r[i] = Reader::read(frame + bps);
+    }
+    return;
+  }
+  for (size_t i = 0; i < frames; ++i) {
+    const uint8_t* frame = src + i * stride;
+    for (int c = 0; c < channels; ++c) {
+      dst[static_cast<size_t>(c)][i] = Reader::read(frame + bps * static_cast<size_t>(c));
+    }
+  }
+}
+
+template <template <bool> class Reader>
+void decodeOrdered(bool swapped, const uint8_t* src, size_t frames, int channels,
+                   std::vector<std::vector<float>>& planes) {
+  if (swapped) {
+    decode<Reader<true>>(src, frames, channels, planes);
+  } else {
+    decode<Reader<false>>(src, frames, channels, planes);
+  }
+}
+
+void decodeAny(const AudioInputFormat& fmt, const uint8_t* src, size_t frames,
+               std::vector<std::vector<float>>& planes) {
+  const bool sw = fmt.swapped;
+  switch (fmt.format) {
+    case SampleFormat::U8: decode<U8Reader>(src, frames, fmt.channels, planes); break;
+    case SampleFormat::S16: decodeOrdered<S16Reader>(sw, src, frames, fmt.channels, planes); break;
+    case SampleFormat::S24: decodeOrdered<S24Reader>(sw, src, frames, fmt.channels, planes); break;
+    case SampleFormat::S24_32: decodeOrdered<S24In32Reader>(sw, src, frames, fmt.channels, planes); break;
+    case SampleFormat::S32: decodeOrdered<S32Reader>(sw, src, frames, fmt.channels, planes); break;
+    case SampleFormat::F32: decodeOrdered<F32Reader>(sw, src, frames, fmt.channels, planes); break;
+    case SampleFormat::F64: decodeOrdered<F64Reader>(sw, src, frames, fmt.channels, planes); break;
+  }
+}
+
+size_t bytesPerSample(SampleFormat f) {
+  switch (f) {
+    case SampleFormat::U8: return 1;
+    case SampleFormat::S16: return 2;
+    case SampleFormat::S24: return 3;
+    case SampleFormat::S24_32: return 4;
+    case SampleFormat::S32: return 4;
+    case SampleFormat::F32: return 4;
+    case SampleFormat::F64: return 8;
+  }
+  return 0;
+}
+
+// frames / rate in ns without overflowing for long runs.
+uint64_t framesToNs(uint64_t frames, int rate) {
+  const uint64_t r = static_cast<uint64_t>(rate);
+  return frames / r * 1000000000ull + frames % r * 1000000000ull / r;
+}
+
+// Input that arrives this far from where its sample count puts it (a gap, a
+// leaky-queue drop, a clock step) moves the timeline instead of drifting.
+constexpr int64_t kResyncNs = 20000000;
+
+}  // namespace
+
+size_t AudioInputFormat::bytesPerFrame() const {
+  return bytesPerSample(format) * static_cast<size_t>(std::max(channels, 0));
+}
+
+AudioConversionEngine::AudioConversionEngine(int outputRate) : outputRate_(outputRate) {}
+
+AudioConversionEngine::~AudioConversionEngine() {
+  stop();
+}
+
+int AudioConversionEngine::addSource(OutputFn output) {
+  auto s = std::make_shared<Source>();
+  s->output = std::move(output);
+  std::lock_guard<std::mutex> lock(sourcesMtx_);
+  const int id = nextId_++;
+  sources_.emplace(id, std::move(s));
+  return id;
+}
+
+void AudioConversionEngine::removeSource(int id) {
+  std::lock_guard<std::mutex> process(processMtx_);
+  std::lock_guard<std::mutex> lock(sourcesMtx_);
+  sources_.erase(id);
+}
+
+std::shared_ptr<AudioConversionEngine::Source> AudioConversionEngine::find(int id) {
+  std::lock_guard<std::mutex> lock(sourcesMtx_);
+  auto it = sources_.find(id);
+  return it == sources_.end() ? nullptr : it->second;
+}
+
+// Returns the source with stagingMtx held, ready to append in format.
+std::shared_ptr<AudioConversionEngine::Source> AudioConversionEngine::stage(
+    int id, const AudioInputFormat& format, uint64_t ptsNs) {
+  std::shared_ptr<Source> s = find(id);
+  if (!s) return nullptr;
+  s->stagingMtx.lock();
+  if (!(s->stagedFormat == format)) {
+    s->staged.clear();
+    s->stagedFormat = format;
+  }
+  if (s->staged.empty()) s->stagedPts = ptsNs;
+  return s;
+}
+
+void AudioConversionEngine::push(int id, const AudioInputFormat& format, const void* data,
+                                 size_t frames, uint64_t ptsNs) {
+  const size_t bytes = frames * format.bytesPerFrame();
+  if (bytes == 0 || format.rate <= 0) return;
+  std::shared_ptr<Source> s = stage(id, format, ptsNs);
+  if (!s) return;
+  std::lock_guard<std::mutex> lock(s->stagingMtx, std::adopt_lock);
+
+  const auto* p = static_cast<const uint8_t*>(data);
+  s->staged.insert(s->staged.end(), p, p + bytes);
+}
+
+void AudioConversionEngine::pushPlanar(int id, const AudioInputFormat& format,
+                                       const void* const* planes, size_t frames, uint64_t ptsNs) {
+  const size_t bytes = frames * format.bytesPerFrame();
+  if (bytes == 0 || format.rate <= 0) return;
+  std::shared_ptr<Source> s = stage(id, format, ptsNs);
+  if (!s) return;
+  std::lock_guard<std::mutex> lock(s->stagingMtx, std::adopt_lock);
+
+  const size_t bps = bytesPerSample(format.format);
+  const size_t old = s->staged.size();
+  s->staged.resize(old + bytes);
+  uint8_t* dst = s->staged.data() + old;
+  for (size_t i = 0; i < frames; ++i) {
+    for (int c = 0; c < format.channels; ++c) {
+      std::memcpy(dst, static_cast<const uint8_t*>(planes[c]) + i * bps, bps);
+      dst += bps;
+    }
+  }
+}
+
+void AudioConversionEngine::configure(Source& s, const AudioInputFormat& format) {
+  s.format = format;
+  s.planar.assign(static_cast<size_t>(format.channels), {});
+  s.out.assign(static_cast<size_t>(format.channels), {});
+  s.resamplers.clear();
+  s.delayNs = 0;
+  if (format.rate != outputRate_) {
+    auto bank = PolyphaseFilterBank::forRates(format.rate, outputRate_);
+    for (int c = 0; c < format.channels; ++c) s.resamplers.emplace_back(bank);
+    s.delayNs = static_cast<int64_t>(bank->delay() * 1e9 / format.rate);
+  }
+  s.timed = false;
+  s.inFrames = 0;
+  s.outFrames = 0;
+}
+
+void AudioConversionEngine::processPending() {
+  std::lock_guard<std::mutex> process(processMtx_);
+  SM_TRACE_SCOPE(trace::kCoarse, "audio", "AudioConversionEngine::processPending");
+
+  std::vector<Source*> batch;
+  {
+    std::lock_guard<std::mutex> lock(sourcesMtx_);
+    batch.reserve(sources_.size());
+    for (auto& [id, s] : sources_) batch.push_back(s.get());
+  }
+
+  // Pass 1: take staged bytes and decode everything to planar float.
+  for (Source* s : batch) {
+    AudioInputFormat fmt;
+    uint64_t pts;
+    {
+      std::lock_guard<std::mutex> lock(s->stagingMtx);
+      fmt = s->stagedFormat;
+      pts = s->stagedPts;
+      s->work.swap(s->staged);
+      s->staged.clear();
+    }
+    if (s->work.empty()) continue;
+    if (!(s->format == fmt)) configure(*s, fmt);
+
+    if (pts != kNoTimestamp) {
+      const int64_t origin = static_cast<int64_t>(pts - framesToNs(s->inFrames, fmt.rate));
+      if (!s->timed || std::abs(origin - s->originNs) > kResyncNs) {
+        s->originNs = origin;
+        s->timed = true;
+      }
+    }
+    const size_t frames = s->work.size() / fmt.bytesPerFrame();
+    decodeAny(fmt, s->work.data(), frames, s->planar);
+    s->inFrames += frames;
+    s->work.clear();
+  }
+
+  // Pass 2: resample, grouped by filter bank so shared coefficients stay hot.
+  auto bankOf = [](const Source* s) {
+    return s->resamplers.empty() ? nullptr : s->resamplers.front().bank();
+  };
+  std::stable_sort(batch.begin(), batch.end(), [&](const Source* a, const Source* b) {
+    return std::less<const PolyphaseFilterBank*>()(bankOf(a), bankOf(b));
+  });
+  for (Source* s : batch) {
+    for (size_t c = 0; c < s->planar.size(); ++c) {
+      auto& in = s->planar[c];
+      if (in.empty()) continue;
+      if (s->resamplers.empty()) {
+        s->out[c].insert(s->out[c].end(), in.begin(), in.end());
+      } else {
+        s->resamplers[c].process(in.data(), in.size(), s->out[c]);
+      }
+      in.clear();
+    }
+  }
+
+  // Pass 3: hand planar output to each source.
+  std::vector<const float*> planes;
+  for (Source* s : batch) {
+    if (s->out.empty() || s->out.front().empty()) continue;
+    const size_t frames = s->out.front().size();
+    planes.clear();
+    for (auto& ch : s->out) planes.push_back(ch.data());
+
+    uint64_t pts = kNoTimestamp;
+    uint64_t duration = kNoTimestamp;
+    if (s->timed) {
+      // Derived from frame counts, so consecutive blocks tile without gaps
+      const uint64_t begin = framesToNs(s->outFrames, outputRate_);
+      const uint64_t end = framesToNs(s->outFrames + frames, outputRate_);
+      pts = static_cast<uint64_t>(
+          std::max<int64_t>(0, s->originNs + static_cast<int64_t>(begin) - s->delayNs));
+      duration = end - begin;
+    }
+    s->outFrames += frames;
+    if (s->output) s->output(planes.data(), static_cast<int>(planes.size()), frames, pts, duration);
+    for (auto& ch : s->out) ch.clear();
+  }
+}
+
+void AudioConversionEngine::start(std::chrono::milliseconds period) {
+  if (running_.exchange(true)) return;
+  thread_ = std::thread([this, period] {
+    trace::setThreadName("audio-engine");
+    auto next = std::chrono::steady_clock::now();
+    while (running_.load()) {
+      next += period;
+      std::this_thread::sleep_until(next);
+      processPending();
+    }
+  });
+}
+
+void AudioConversionEngine::stop() {
+  if (!running_.exchange(false)) return;
+  if (thread_.joinable()) thread_.join();
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "audio/PolyphaseFilterBank.h"
+
+// Input sample formats the engine decodes itself. S24 is packed 3-byte,
+// S24_32 is 24 bits in the low bytes of a 32-bit word.
+enum class SampleFormat { U8, S16, S24, S24_32, S32, F32, F64 };
+
+struct AudioInputFormat {
+  SampleFormat format{SampleFormat::F32};
+  int channels{0};
+  int rate{0};
+  bool swapped{false};  // samples are in the opposite of host byte order
+
+  bool operator==(const AudioInputFormat&) const = default;
+  size_t bytesPerFrame() const;
+};
+
+// Converts every registered source to planar float at one internal rate.
+//
+// Capture threads only append raw bytes to a per-source staging buffer. One
+// engine thread wakes once per period and runs the conversion for all sources
+// in batched passes: first decode/deinterleave everything, then resample
+// grouped by filter bank so sources sharing a rate ratio reuse warm
+// coefficients back to back.
+//
+// Timestamps follow the samples, not the engine's wake-ups: each output block
+// is stamped from the input timestamp plus the number of frames converted
+// since, so output keeps the capture clock's alignment and has no period
+// jitter.
+class AudioConversionEngine {
+public:
+  static constexpr uint64_t kNoTimestamp = UINT64_MAX;
+
+  // Called from the engine thread with one plane per channel. ptsNs is the
+  // time of the first frame and durationNs the block length, both
+  // kNoTimestamp if the input carried none.
+  using OutputFn = std::function<void(const float* const* planes, int channels, size_t frames,
+                                      uint64_t ptsNs, uint64_t durationNs)>;
+
+  explicit AudioConversionEngine(int outputRate = 48000);
+  ~AudioConversionEngine();
+
+  int outputRate() const { return outputRate_; }
+
+  int addSource(OutputFn output);
+  // After this returns the source's output callback will not be called again.
+  void removeSource(int id);
+
+  // Thread-safe; a format change discards anything still staged. ptsNs is
+  // the time of the first frame.
+  void push(int id, const AudioInputFormat& format, const void* data, size_t frames,
+            uint64_t ptsNs = kNoTimestamp);
+  // Same for non-interleaved input, one plane per channel. The planes are
+  // interleaved while staging so the conversion pass sees a single layout.
+  void pushPlanar(int id, const AudioInputFormat& format, const void* const* planes, size_t frames,
+                  uint64_t ptsNs = kNoTimestamp);
+
+  // Runs one batched conversion pass over every source with staged input.
+  void processPending();
+
+  void start(std::chrono::milliseconds period = std::chrono::milliseconds(10));
+  void stop();
+
+private:
+  struct Source {
+    OutputFn output;
+
+    std::mutex stagingMtx;  // guards the three fields below
+    AudioInputFormat stagedFormat;
+    std::vector<uint8_t> staged;
+    uint64_t stagedPts{kNoTimestamp};  // time of the first staged frame
+
+    // Engine-thread state
+    AudioInputFormat format;
+    std::vector<uint8_t> work;
+    std::vector<std::vector<float>> planar;   // decoded input, one vector per channel
+    std::vector<std::vector<float>> out;      // output at outputRate_
+    std::vector<PolyphaseResampler> resamplers;  // empty when rates match
+
+    // Timeline since configure(): origin is the time of input frame 0, output
+    // frame k lies at origin + k / outputRate_ - delay.
+    bool timed{false};
+    int64_t originNs{0};
+    int64_t delayNs{0};  // resampler group delay
+    uint64_t inFrames{0};
+    uint64_t outFrames{0};
+  };
+
+  std::shared_ptr<Source> find(int id);
+  std::shared_ptr<Source> stage(int id, const AudioInputFormat& format, uint64_t ptsNs);
+  void configure(Source& s, const AudioInputFormat& format);
+
+  const int outputRate_;
+
+  std::mutex processMtx_;  // serializes processPending() against removeSource()
+  std::mutex sourcesMtx_;  // guards sources_; held only for lookups
+  std::map<int, std::shared_ptr<Source>> sources_;
+  int nextId_{1};
+
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+};
@@ -0,0 +1,133 @@
+#include "PolyphaseFilterBank.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+// Taps per phase when upsampling; scaled up with the decimation factor so
+// the transition band stays the same width relative to the output rate.
+constexpr int kBaseTaps = 32;
+// Cutoff as a fraction of the lower Nyquist frequency.
+constexpr double kRolloff = 0.92;
+constexpr double kPi = 3.14159265358979323846;
+
+double sinc(double x) {
+  if (std::abs(x) < 1e-12) return 1.0;
+  const double px = kPi * x;
+  return std::sin(px) / px;
+}
+
+double blackman(double i, double n) {
+  const double a = 2.0 * kPi * i / (n - 1);
+  return 0.42 - 0.5 * std::cos(a) + 0.08 * std::cos(2.0 * a);
+}
+
+}  // namespace
+
+std::shared_ptr<const PolyphaseFilterBank> PolyphaseFilterBank::forRates(int inRate, int outRate) {
+  if (inRate <= 0 || outRate <= 0) return nullptr;
+  const int g = std::gcd(inRate, outRate);
+  const std::pair<int, int> key{outRate / g, inRate / g};
+
+  static std::mutex mtx;
+  static std::map<std::pair<int, int>, std::weak_ptr<const PolyphaseFilterBank>> cache;
+
+  std::lock_guard<std::mutex> lock(mtx);
+  if (auto existing = cache[key].lock()) return existing;
+  auto bank = std::make_shared<const PolyphaseFilterBank>(key.first, key.second);
+  cache[key] = bank;
+  return bank;
+}
+
+PolyphaseFilterBank::PolyphaseFilterBank(int up, int down)
+    : up_(up), down_(down), taps_(kBaseTaps * ((down + up - 1) / up)) {
+  const size_t n = static_cast<size_t>(up_) * taps_;
+  const double cutoff = 0.5 * kRolloff / std::max(up_, down_);  // relative to up * inRate
+  const double center = (static_cast<double>(n) - 1.0) / 2.0;
+
+  std::vector<double> proto(n);
+  double sum = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    const double t = static_cast<double>(i) - center;
+    proto[i] = 2.0 * cutoff * sinc(2.0 * cutoff * t) * blackman(static_cast<double>(i), static_cast<double>(n));
+    sum += proto[i];
+  }
+
+  // Unity DC gain per phase: the prototype sums to 1, each of the `up`
+  // phases to roughly 1/up.
+  const double gain = static_cast<double>(up_) / sum;
+  coeffs_.resize(n);
+  for (int p = 0; p < up_; ++p) {
+    float* c = coeffs_.data() + static_cast<size_t>(p) * taps_;
+    for (int j = 0; j < taps_; ++j) {
+      const size_t k = static_cast<size_t>(taps_ - 1 - j);
+      c[j] = static_cast<float>(proto[static_cast<size_t>(p) + k * up_] * gain);
+    }
+  }
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+typedef float f32x4 __attribute__((vector_size(16)));
+
+float PolyphaseFilterBank::apply(int p, const float* x) const {
+  // taps_ is always a multiple of kBaseTaps, hence of 8
+  const float* c = phase(p);
+  f32x4 acc0 = {0, 0, 0, 0};
+  f32x4 acc1 = {0, 0, 0, 0};
+  for (int j = 0; j < taps_; j += 8) {
+    f32x4 c0, c1, x0, x1;
+    std::memcpy(&c0, c + j, sizeof(c0));
+    std::memcpy(&c1, c + j + 4, sizeof(c1));
+    std::memcpy(&x0, x + j, sizeof(x0));
+    std::memcpy(&x1, x + j + 4, sizeof(x1));
+    acc0 += c0 * x0;
+    acc1 += c1 * x1;
+  }
+  const f32x4 acc = acc0 + acc1;
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+#else
+float PolyphaseFilterBank::apply(int p, const float* x) const {
+  const float* c = phase(p);
+  float acc = 0.f;
+  for (int j = 0; j < taps_; ++j) acc += c[j] * x[j];
+  return acc;
+}
+#endif
+
+PolyphaseResampler::PolyphaseResampler(std::shared_ptr<const PolyphaseFilterBank> bank)
+    : bank_(std::move(bank)),
+      history_(static_cast<size_t>(bank_->taps() - 1), 0.f),
+      pos_(static_cast<size_t>(bank_->taps() - 1)) {}
+
+void PolyphaseResampler::process(const float* in, size_t n, std::vector<float>& out) {
+  const PolyphaseFilterBank& b = *bank_;
+  const size_t history = static_cast<size_t>(b.taps() - 1);
+  history_.insert(history_.end(), in, in + n);
+
+  const size_t avail = history_.size();
+  const int up = b.up();
+  const int down = b.down();
+  out.reserve(out.size() + (n * up) / down + 1);
+
+  const float* x = history_.data();
+  size_t pos = pos_;
+  int phase = phase_;
+  while (pos < avail) {
+    out.push_back(b.apply(phase, x + pos - history));
+    phase += down;
+    pos += static_cast<size_t>(phase / up);
+    phase %= up;
+  }
+
+  // Keep only the history the next output still needs.
+  const size_t drop = std::min(pos - history, avail);
+  history_.erase(history_.begin(), history_.begin() + static_cast<std::ptrdiff_t>(drop));
+  pos_ = pos - drop;
+  phase_ = phase;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Windowed-sinc polyphase filter bank for a rational rate change L/M.
+// Banks are immutable and cached by reduced ratio, so every source that
+// converts e.g. 44.1 kHz -> 48 kHz shares one set of coefficients.
+class PolyphaseFilterBank {
+public:
+  static std::shared_ptr<const PolyphaseFilterBank> forRates(int inRate, int outRate);
+
+  int up() const { return up_; }
+  int down() const { return down_; }
+  int taps() const { return taps_; }
+  // Group delay of the linear-phase prototype, in input samples.
+  double delay() const { return (static_cast<double>(up_) * taps_ - 1.0) / (2.0 * up_); }
+
+  // Coefficients for one phase, ordered oldest-sample first so they line up
+  // with a contiguous run of input history.
+  const float* phase(int p) const { return coeffs_.data() + static_cast<size_t>(p) * taps_; }
+
+  // Dot product of phase p with x[0..taps()).
+  float apply(int p, const float* x) const;
+
+  PolyphaseFilterBank(int up, int down);
+
+private:
+  int up_;
+  int down_;
+  int taps_;
+  std::vector<float> coeffs_;  // [phase][tap]
+};
+
+// Per-channel streaming state on top of a shared bank.
+class PolyphaseResampler {
+public:
+  explicit PolyphaseResampler(std::shared_ptr<const PolyphaseFilterBank> bank);
+
+  const PolyphaseFilterBank* bank() const { return bank_.get(); }
+
+  // Consumes n input samples and appends the produced output samples.
+  void process(const float* in, size_t n, std::vector<float>& out);
+
+private:
+  std::shared_ptr<const PolyphaseFilterBank> bank_;
+  std::vector<float> history_;  // taps-1 samples of history followed by pending input
+  size_t pos_;                  // index in history_ of the newest sample of the next output
+  int phase_{0};
+};
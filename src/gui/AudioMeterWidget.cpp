@@ -2,6 +2,7 @@
 #include <QPainter>
 #include <algorithm>
 #include <cmath>
+#include "trace/Trace.h"
 
 static float dbToNorm(float db) {
   if (!std::isfinite(db)) return 0.f;
@@ -15,6 +16,15 @@ AudioMeterWidget::AudioMeterWidget(QWidget* parent) : QWidget(parent) {
 }
 
 void AudioMeterWidget::setPeakLevels(const QVector<float>& dbLevels) {
+  if (!dbLevels.isEmpty()) {
+    // level reports -inf on silence; clamp to the meter floor so the counter
+    // track stays plottable
+    float peak = -60.f;
+    for (float db : dbLevels) {
+      if (std::isfinite(db)) peak = std::max(peak, db);
+    }
+    SM_TRACE_COUNTER(trace::kCoarse, "meter", "peak-dbfs", peak);
+  }
   {
     QMutexLocker lock(&mtx_);
     levelsDb_ = dbLevels;
@@ -23,6 +33,7 @@ void AudioMeterWidget::setPeakLevels(const QVector<float>& dbLevels) {
 }
 
 void AudioMeterWidget::paintEvent(QPaintEvent*) {
+  SM_TRACE_SCOPE(trace::kCoarse, "ui", "AudioMeterWidget::paint");
   QPainter p(this);
   p.fillRect(rect(), QColor(20, 20, 20));
 
@@ -1,11 +1,16 @@
 #include "MainWindow.h"
 #include <QGroupBox>
 #include <QHBoxLayout>
+#include <QDateTime>
+#include <QDir>
 #include <QLabel>
+#include <QShortcut>
+#include <QStatusBar>
+#include "trace/Trace.h"
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
   setWindowTitle("Stream Matrix - Preview");
-  resize(1100, 700);
+  resize(1100, 1000);
 
   central_ = new QWidget(this);
   auto* root = new QVBoxLayout(central_);
@@ -45,8 +50,15 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
   previewRow->setStretchFactor(videoGroup, 4);
   previewRow->setStretchFactor(audioGroup, 1);
 
+  // Scopes group
+  auto* scopesGroup = new QGroupBox("Scopes", central_);
+  auto* scopesLayout = new QVBoxLayout(scopesGroup);
+  scopes_ = new ScopeWidget(scopesGroup);
+  scopesLayout->addWidget(scopes_);
+
   root->addLayout(ctrlRow);
   root->addLayout(previewRow, 1);
+  root->addWidget(scopesGroup);
 
   setCentralWidget(central_);
 
@@ -54,6 +66,16 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
   connect(videoCombo_, &QComboBox::currentIndexChanged, this, &MainWindow::onSelectionChanged);
   connect(audioCombo_, &QComboBox::currentIndexChanged, this, &MainWindow::onSelectionChanged);
 
+  // Ctrl+Shift+T writes the trace rings to a Chrome/Perfetto JSON file
+  auto* dumpTrace = new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_T), this);
+  connect(dumpTrace, &QShortcut::activated, this, &MainWindow::onDumpTrace);
+
+  connect(&preview_.supervisor(), &PipelineSupervisor::branchRecovered, this,
+          [this](const QString& name, double recoveryMs) {
+            statusBar()->showMessage(
+                QString("Restarted %1 branch in %2 ms").arg(name).arg(recoveryMs, 0, 'f', 0), 5000);
+          });
+
   populateDeviceLists();
   onSelectionChanged();
 }
@@ -107,5 +129,16 @@ void MainWindow::onSelectionChanged() {
     adev = deviceMgr_.audio(audioCombo_->currentIndex()).device;
   }
 
-  preview_.start(vdev, adev, videoWidget_, audioMeters_);
-}
\ No newline at end of file
+  preview_.start(vdev, adev, videoWidget_, audioMeters_, scopes_);
+}
+
+void MainWindow::onDumpTrace() {
+  const QString path = QDir(QDir::tempPath()).filePath(
+      QString("streammatrix-trace-%1.json")
+          .arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss")));
+  if (trace::dumpChromeJson(path.toStdString())) {
+    statusBar()->showMessage("Trace written to " + path, 5000);
+  } else {
+    statusBar()->showMessage("Failed to write trace to " + path, 5000);
+  }
+}
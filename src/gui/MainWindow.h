@@ -4,6 +4,7 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 #include "gui/AudioMeterWidget.h"
+#include "gui/ScopeWidget.h"
 #include "gui/VideoWidget.h"
 #include "pipeline/DeviceManager.h"
 #include "pipeline/PreviewPipeline.h"
@@ -17,6 +18,7 @@ public:
 private slots:
   void onRefreshDevices();
   void onSelectionChanged();
+  void onDumpTrace();
 
 private:
   void populateDeviceLists();
@@ -27,6 +29,7 @@ private:
   QPushButton* refreshBtn_{nullptr};
   VideoWidget* videoWidget_{nullptr};
   AudioMeterWidget* audioMeters_{nullptr};
+  ScopeWidget* scopes_{nullptr};
 
   DeviceManager deviceMgr_;
   PreviewPipeline preview_;
@@ -0,0 +1,176 @@
+#include "ScopeWidget.h"
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+#include "trace/Trace.h"
+
+namespace {
+
+// Maps hit counts to 0..255 on a log scale so sparse traces stay visible.
+// log1p is evaluated once per table entry instead of once per bin. Counts
+// below kFine are exact, which covers waveform and parade (bounded by the
+// proxy height); larger ones only occur on the vectorscope and are looked up
+// in buckets of 2^shift, where the log curve is already flat.
+class IntensityLut {
+public:
+  explicit IntensityLut(uint32_t maxCount) {
+    const float inv = maxCount > 0 ? 1.f / std::log1p(static_cast<float>(maxCount)) : 0.f;
+    auto at = [inv](uint32_t count) {
+      return static_cast<uint8_t>(
+          std::min(255, static_cast<int>(std::log1p(static_cast<float>(count)) * inv * 255.f)));
+    };
+    fine_.resize(std::min<uint32_t>(maxCount, kFine - 1) + 1);
+    for (uint32_t c = 0; c < fine_.size(); ++c) fine_[c] = at(c);
+    if (maxCount >= kFine) {
+      while ((maxCount >> shift_) >= kFine) ++shift_;
+      coarse_.resize((maxCount >> shift_) + 1);
+      const uint32_t half = 1u << (shift_ - 1);
+      for (uint32_t j = 0; j < coarse_.size(); ++j) coarse_[j] = at((j << shift_) + half);
+    }
+  }
+
+  uint8_t operator()(uint32_t count) const {
+    return count < fine_.size() ? fine_[count] : coarse_[count >> shift_];
+  }
+
+private:
+  static constexpr uint32_t kFine = 4096;
+  std::vector<uint8_t> fine_;
+  std::vector<uint8_t> coarse_;
+  uint32_t shift_{0};
+};
+
+template <typename T>
+IntensityLut lutFor(const std::vector<T>& counts) {
+  return IntensityLut(counts.empty() ? 0u : *std::max_element(counts.begin(), counts.end()));
+}
+
+QRgb* pixelRow(QImage& img, int y) {
+  return reinterpret_cast<QRgb*>(img.bits() + static_cast<qsizetype>(y) * img.bytesPerLine());
+}
+
+}  // namespace
+
+ScopeWidget::ScopeWidget(QWidget* parent)
+    : QWidget(parent), buffer_(std::make_shared<ScopeBuffer>()) {
+  setMinimumSize(480, 240);
+  pollTimer_.setInterval(66);
+  connect(&pollTimer_, &QTimer::timeout, this, &ScopeWidget::pollFrame);
+  pollTimer_.start();
+}
+
+void ScopeWidget::pollFrame() {
+  const ScopeFrame* f = buffer_->acquire();
+  const bool fresh = f && f->seq != lastSeq_ && f->width > 0;
+  if (fresh) {
+    renderFrame(*f);
+    lastSeq_ = f->seq;
+  }
+  buffer_->release();
+  if (fresh) update();
+}
+
+void ScopeWidget::renderFrame(const ScopeFrame& f) {
+  SM_TRACE_SCOPE(trace::kCoarse, "ui", "ScopeWidget::renderFrame");
+  constexpr int L = ScopeFrame::kLevels;
+  const int w = f.width;
+
+  // Waveform: x = image column, y = luma (white at the top)
+  waveform_ = QImage(w, L, QImage::Format_RGB32);
+  const IntensityLut waveLut = lutFor(f.waveform);
+  for (int x = 0; x < w; ++x) {
+    const uint16_t* col = f.waveform.data() + static_cast<size_t>(x) * L;
+    for (int v = 0; v < L; ++v) {
+      const int i = waveLut(col[v]);
+      pixelRow(waveform_, L - 1 - v)[x] = qRgb(i / 3, i, i / 3);
+    }
+  }
+
+  // Parade: R, G and B waveforms side by side
+  parade_ = QImage(3 * w, L, QImage::Format_RGB32);
+  const IntensityLut paradeLut = lutFor(f.parade);
+  QRgb paradeColors[3][256];
+  for (int i = 0; i < 256; ++i) {
+    paradeColors[0][i] = qRgb(i, i / 4, i / 4);
+    paradeColors[1][i] = qRgb(i / 4, i, i / 4);
+    paradeColors[2][i] = qRgb(i / 4, i / 4, i);
+  }
+  for (int c = 0; c < 3; ++c) {
+    for (int x = 0; x < w; ++x) {
+      const uint16_t* col = f.parade.data() + (static_cast<size_t>(c) * w + x) * L;
+      for (int v = 0; v < L; ++v) {
+        pixelRow(parade_, L - 1 - v)[c * w + x] = paradeColors[c][paradeLut(col[v])];
+      }
+    }
+  }
+
+  // Vectorscope: x = Cb, y = Cr (red towards the top)
+  vectorscope_ = QImage(L, L, QImage::Format_RGB32);
+  const IntensityLut vecLut = lutFor(f.vectorscope);
+  for (int cr = 0; cr < L; ++cr) {
+    QRgb* line = pixelRow(vectorscope_, L - 1 - cr);
+    const uint32_t* src = f.vectorscope.data() + static_cast<size_t>(cr) * L;
+    for (int cb = 0; cb < L; ++cb) {
+      const int i = vecLut(src[cb]);
+      line[cb] = qRgb(i, i, i);
+    }
+  }
+
+  // Histogram: additive R/G/B columns with luma as a grey outline
+  constexpr int histH = 128;
+  histogram_ = QImage(L, histH, QImage::Format_RGB32);
+  histogram_.fill(Qt::black);
+  uint32_t histMax = 1;
+  for (uint32_t v : f.histogram) histMax = std::max(histMax, v);
+  for (int v = 0; v < L; ++v) {
+    int heights[4];
+    for (int c = 0; c < 4; ++c) {
+      heights[c] = static_cast<int>(static_cast<uint64_t>(f.histogram[c * L + v]) * histH / histMax);
+    }
+    for (int y = 0; y < histH; ++y) {
+      const int fromBottom = histH - 1 - y;
+      const int r = fromBottom < heights[0] ? 200 : 0;
+      const int g = fromBottom < heights[1] ? 200 : 0;
+      const int b = fromBottom < heights[2] ? 200 : 0;
+      const bool lumaEdge = fromBottom == std::max(0, heights[3] - 1) && heights[3] > 0;
+      pixelRow(histogram_, y)[v] = lumaEdge ? qRgb(255, 255, 255) : qRgb(r, g, b);
+    }
+  }
+}
+
+void ScopeWidget::paintEvent(QPaintEvent*) {
+  SM_TRACE_SCOPE(trace::kCoarse, "ui", "ScopeWidget::paint");
+  QPainter p(this);
+  p.fillRect(rect(), QColor(20, 20, 20));
+
+  if (waveform_.isNull()) {
+    p.setPen(Qt::gray);
+    p.drawText(rect(), Qt::AlignCenter, "No video");
+    return;
+  }
+
+  const int spacing = 6;
+  const int cellW = (width() - 3 * spacing) / 2;
+  const int cellH = (height() - 3 * spacing) / 2;
+  const QRect cells[4] = {
+      QRect(spacing, spacing, cellW, cellH),
+      QRect(2 * spacing + cellW, spacing, cellW, cellH),
+      QRect(spacing, 2 * spacing + cellH, cellW, cellH),
+      QRect(2 * spacing + cellW, 2 * spacing + cellH, cellW, cellH),
+  };
+  const QImage* images[4] = {&waveform_, &parade_, &vectorscope_, &histogram_};
+  const char* labels[4] = {"Waveform", "RGB Parade", "Vectorscope", "Histogram"};
+
+  p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+  for (int i = 0; i < 4; ++i) {
+    QRect target = cells[i];
+    if (images[i] == &vectorscope_) {
+      // keep the vectorscope square so hue angles are not skewed
+      const int side = std::min(target.width(), target.height());
+      target = QRect(target.center().x() - side / 2, target.top(), side, side);
+    }
+    p.drawImage(target, *images[i]);
+    p.setPen(QColor(150, 150, 150));
+    p.drawText(cells[i].adjusted(4, 2, 0, 0), Qt::AlignLeft | Qt::AlignTop, labels[i]);
+  }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <QImage>
+#include <QTimer>
+#include <QWidget>
+#include <memory>
+#include "scopes/ScopeBuffer.h"
+
+// Draws luma waveform, RGB parade, vectorscope and histogram for one source.
+// The streaming thread publishes accumulators into buffer(); this widget
+// polls it on a timer and only converts a frame to images when it changed.
+class ScopeWidget : public QWidget {
+  Q_OBJECT
+public:
+  explicit ScopeWidget(QWidget* parent = nullptr);
+
+  std::shared_ptr<ScopeBuffer> buffer() const { return buffer_; }
+
+  QSize sizeHint() const override { return {640, 300}; }
+
+protected:
+  void paintEvent(QPaintEvent*) override;
+
+private slots:
+  void pollFrame();
+
+private:
+  void renderFrame(const ScopeFrame& f);
+
+  std::shared_ptr<ScopeBuffer> buffer_;
+  QTimer pollTimer_;
+  uint64_t lastSeq_{0};
+
+  QImage waveform_;
+  QImage parade_;
+  QImage vectorscope_;
+  QImage histogram_;
+};
@@ -1,11 +1,13 @@
 #include <QApplication>
 #include "gui/MainWindow.h"
 #include <gst/gst.h>
+#include "trace/Trace.h"
 
 int main(int argc, char* argv[]) {
   // Initialize GStreamer before Qt uses any of it
   gst_init(&argc, &argv);
   gst_value_array_get_type();
+  trace::setThreadName("ui");
   QApplication app(argc, argv);
   MainWindow w;
   w.show();
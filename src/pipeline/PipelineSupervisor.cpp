@@ -0,0 +1,269 @@
+#include "PipelineSupervisor.h"
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include "trace/Trace.h"
+
+namespace {
+
+constexpr uint64_t kMs = 1000000;  // ns per ms
+
+// A branch that never produces a buffer after (re)starting counts as failed.
+constexpr uint64_t kStartupTimeoutNs = 3000 * kMs;
+// Consecutive failures back off from 100 ms up to 5 s; the first restart
+// after a healthy period is immediate.
+constexpr uint64_t kBackoffBaseNs = 100 * kMs;
+constexpr uint64_t kBackoffMaxNs = 5000 * kMs;
+// Running this long without a failure resets the backoff.
+constexpr uint64_t kHealthyNs = 5000 * kMs;
+
+uint64_t monotonicNs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+}  // namespace
+
+struct PipelineSupervisor::Branch {
+  BranchSpec spec;
+  GstElement* pipeline{nullptr};
+  GstBus* bus{nullptr};
+
+  // Written from the watched pad's streaming thread
+  std::atomic<uint64_t> lastBufferNs{0};
+  std::atomic<uint64_t> firstBufferNs{0};  // 0 until the first buffer of this instance
+  std::mutex capsMtx;
+  GstCaps* cachedCaps{nullptr};  // guarded by capsMtx
+
+  // UI thread only
+  uint64_t startedNs{0};
+  uint64_t failedNs{0};     // start of the outage being recovered
+  uint64_t restartAtNs{0};  // pending restart; 0 = none
+  int consecutiveFailures{0};
+  bool recovering{false};
+  bool usedCachedCaps{false};
+
+  ~Branch() {
+    if (cachedCaps) gst_caps_unref(cachedCaps);
+  }
+};
+
+PipelineSupervisor::PipelineSupervisor() {
+  clock_ = gst_system_clock_obtain();
+  tickTimer_.setInterval(30);
+  connect(&tickTimer_, &QTimer::timeout, this, &PipelineSupervisor::tick);
+}
+
+PipelineSupervisor::~PipelineSupervisor() {
+  clear();
+  gst_object_unref(clock_);
+}
+
+void PipelineSupervisor::addBranch(BranchSpec spec) {
+  if (branches_.empty()) {
+    // Every branch runs against the same base time, including restarted
+    // ones, so their running times stay comparable.
+    baseTime_ = gst_clock_get_time(clock_);
+  }
+  branches_.push_back(std::make_unique<Branch>());
+  Branch& b = *branches_.back();
+  b.spec = std::move(spec);
+  launch(b);
+  tickTimer_.start();
+}
+
+void PipelineSupervisor::clear() {
+  tickTimer_.stop();
+  for (auto& b : branches_) teardown(*b);
+  branches_.clear();
+}
+
+GstPadProbeReturn PipelineSupervisor::watchdogProbe(GstPad*, GstPadProbeInfo* info,
+                                                    gpointer user_data) {
+  auto* b = static_cast<Branch*>(user_data);
+  if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent* ev = GST_PAD_PROBE_INFO_EVENT(info);
+    if (ev && GST_EVENT_TYPE(ev) == GST_EVENT_CAPS) {
+      GstCaps* caps = nullptr;
+      gst_event_parse_caps(ev, &caps);
+      std::lock_guard<std::mutex> lock(b->capsMtx);
+      gst_caps_replace(&b->cachedCaps, caps);
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  const uint64_t now = monotonicNs();
+  b->lastBufferNs.store(now, std::memory_order_relaxed);
+  uint64_t none = 0;
+  // release: whoever sees firstBufferNs set also sees lastBufferNs
+  b->firstBufferNs.compare_exchange_strong(none, now, std::memory_order_release,
+                                           std::memory_order_relaxed);
+  return GST_PAD_PROBE_OK;
+}
+
+void PipelineSupervisor::launch(Branch& b) {
+  SM_TRACE_SCOPE(trace::kCoarse, "supervisor", "launchBranch");
+  b.restartAtNs = 0;
+  b.firstBufferNs.store(0);
+  b.lastBufferNs.store(0);
+
+  GstCaps* caps = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(b.capsMtx);
+    if (b.cachedCaps) caps = gst_caps_ref(b.cachedCaps);
+  }
+  b.pipeline = b.spec.build ? b.spec.build(caps) : nullptr;
+  b.usedCachedCaps = caps != nullptr;
+  if (caps) gst_caps_unref(caps);
+
+  if (!b.pipeline) {
+    fail(b, "failed to build");
+    return;
+  }
+
+  gst_pipeline_use_clock(GST_PIPELINE(b.pipeline), clock_);
+  gst_element_set_start_time(b.pipeline, GST_CLOCK_TIME_NONE);
+  gst_element_set_base_time(b.pipeline, baseTime_);
+  b.bus = gst_element_get_bus(b.pipeline);
+
+  if (!b.spec.watchElement.isEmpty()) {
+    GstElement* watched =
+        gst_bin_get_by_name(GST_BIN(b.pipeline), b.spec.watchElement.toUtf8().constData());
+    GstPad* pad = watched ? gst_element_get_static_pad(watched, "src") : nullptr;
+    if (pad) {
+      gst_pad_add_probe(pad,
+                        static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER |
+                                                     GST_PAD_PROBE_TYPE_BUFFER_LIST |
+                                                     GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+                        watchdogProbe, &b, nullptr);
+      gst_object_unref(pad);
+    } else {
+      qWarning() << "Branch" << b.spec.name << "has no watchable pad on" << b.spec.watchElement;
+    }
+    if (watched) gst_object_unref(watched);
+  }
+
+  b.startedNs = monotonicNs();
+  if (gst_element_set_state(b.pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+    fail(b, "failed to start");
+    return;
+  }
+  if (b.spec.started) b.spec.started();
+}
+
+void PipelineSupervisor::teardown(Branch& b) {
+  if (!b.pipeline) return;
+  if (b.spec.stopping) b.spec.stopping();
+  gst_element_set_state(b.pipeline, GST_STATE_NULL);
+  if (b.bus) {
+    gst_object_unref(b.bus);
+    b.bus = nullptr;
+  }
+  gst_object_unref(b.pipeline);
+  b.pipeline = nullptr;
+}
+
+void PipelineSupervisor::fail(Branch& b, const QString& reason) {
+  SM_TRACE_INSTANT(trace::kCoarse, "supervisor", "branchFailed");
+  qWarning() << "Branch" << b.spec.name << "failed:" << reason;
+
+  const bool neverFlowed = b.firstBufferNs.load() == 0;
+  teardown(b);
+
+  const uint64_t now = monotonicNs();
+  if (!b.recovering) {
+    b.failedNs = now;
+    b.recovering = true;
+  }
+  if (neverFlowed && b.usedCachedCaps) {
+    // The pinned caps may be what is failing; let the next attempt renegotiate
+    std::lock_guard<std::mutex> lock(b.capsMtx);
+    gst_caps_replace(&b.cachedCaps, nullptr);
+  }
+
+  uint64_t delay = 0;
+  if (b.consecutiveFailures > 0) {
+    delay = std::min(kBackoffMaxNs, kBackoffBaseNs << std::min(b.consecutiveFailures - 1, 6));
+  }
+  ++b.consecutiveFailures;
+  b.restartAtNs = now + std::max<uint64_t>(delay, 1);
+}
+
+void PipelineSupervisor::pollBus(Branch& b) {
+  while (b.bus) {
+    GstMessage* msg = gst_bus_pop(b.bus);
+    if (!msg) break;
+
+    SM_TRACE_INSTANT(trace::kFine, "bus", GST_MESSAGE_TYPE_NAME(msg));
+    switch (GST_MESSAGE_TYPE(msg)) {
+      case GST_MESSAGE_ERROR: {
+        GError* err = nullptr;
+        gchar* dbg = nullptr;
+        gst_message_parse_error(msg, &err, &dbg);
+        qWarning() << "GStreamer error:" << (err ? err->message : "unknown");
+        if (dbg) {
+          qWarning() << "Debug:" << dbg;
+          g_free(dbg);
+        }
+        const QString reason = err ? QString::fromUtf8(err->message) : QString("error");
+        if (err) g_error_free(err);
+        gst_message_unref(msg);
+        fail(b, reason);  // drops the bus, ends the loop
+        return;
+      }
+      case GST_MESSAGE_EOS:
+        gst_message_unref(msg);
+        fail(b, "unexpected EOS");
+        return;
+      default:
+        if (handler_) handler_(msg);
+        break;
+    }
+
+    gst_message_unref(msg);
+  }
+}
+
+void PipelineSupervisor::tick() {
+  SM_TRACE_SCOPE(trace::kCoarse, "bus", "PipelineSupervisor::tick");
+  const uint64_t now = monotonicNs();
+
+  for (auto& bp : branches_) {
+    Branch& b = *bp;
+    pollBus(b);
+
+    if (b.restartAtNs != 0) {
+      if (now >= b.restartAtNs) launch(b);
+      continue;
+    }
+    if (!b.pipeline) continue;
+
+    const bool watched = !b.spec.watchElement.isEmpty();
+    const uint64_t first = b.firstBufferNs.load(std::memory_order_acquire);
+
+    // Recovery is complete at the first buffer (or at PLAYING for branches
+    // without a watched source).
+    if (b.recovering && (first != 0 || !watched)) {
+      const uint64_t doneNs = first != 0 ? first : b.startedNs;
+      const double ms = static_cast<double>(doneNs - b.failedNs) / kMs;
+      b.recovering = false;
+      qInfo() << "Branch" << b.spec.name << "recovered in" << ms << "ms";
+      SM_TRACE_COUNTER(trace::kCoarse, "supervisor", "recoveryMs", ms);
+      emit branchRecovered(b.spec.name, ms);
+    }
+    if (b.consecutiveFailures > 0 && now - b.startedNs > kHealthyNs && (first != 0 || !watched)) {
+      b.consecutiveFailures = 0;
+    }
+
+    if (!watched || b.spec.stallTimeoutMs <= 0) continue;
+    if (first == 0) {
+      if (now - b.startedNs > kStartupTimeoutNs) fail(b, "no buffers after start");
+    } else {
+      const uint64_t last = b.lastBufferNs.load(std::memory_order_relaxed);
+      if (now > last && now - last > static_cast<uint64_t>(b.spec.stallTimeoutMs) * kMs) {
+        fail(b, "buffer flow stalled");
+      }
+    }
+  }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <gst/gst.h>
+
+// Runs each source/output branch as its own GstPipeline on one shared clock
+// and base time, so a failing device only takes its own branch down.
+//
+// A branch is restarted when its bus reports an error or EOS, or when its
+// watchdog sees no buffers on the watched pad for longer than the stall
+// timeout. Restarts rebuild only that branch, passing the caps it had
+// negotiated before so the builder can pin them and skip device probing.
+// Recovery time (failure detected -> first buffer again) is logged and
+// reported through branchRecovered().
+class PipelineSupervisor : public QObject {
+  Q_OBJECT
+public:
+  struct BranchSpec {
+    QString name;
+    // Returns a new GstPipeline; cachedCaps is null on the first start.
+    std::function<GstElement*(const GstCaps* cachedCaps)> build;
+    // Element whose "src" pad feeds the watchdog and the caps cache. Empty
+    // for branches without a source of their own.
+    QString watchElement;
+    int stallTimeoutMs{0};  // 0 disables the buffer-flow watchdog
+    std::function<void()> started;   // after the pipeline went to PLAYING
+    std::function<void()> stopping;  // before the pipeline is torn down
+  };
+
+  PipelineSupervisor();
+  ~PipelineSupervisor() override;
+
+  // Builds and starts the branch right away.
+  void addBranch(BranchSpec spec);
+  // Tears every branch down.
+  void clear();
+
+  // Receives every bus message that is not handled by the supervisor itself.
+  void setMessageHandler(std::function<void(GstMessage*)> handler) { handler_ = std::move(handler); }
+
+signals:
+  void branchRecovered(const QString& name, double recoveryMs);
+
+private slots:
+  void tick();
+
+private:
+  struct Branch;
+
+  static GstPadProbeReturn watchdogProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+  void launch(Branch& b);
+  void teardown(Branch& b);
+  void fail(Branch& b, const QString& reason);
+  void pollBus(Branch& b);
+
+  GstClock* clock_{nullptr};
+  GstClockTime baseTime_{GST_CLOCK_TIME_NONE};
+  std::vector<std::unique_ptr<Branch>> branches_;
+  std::function<void(GstMessage*)> handler_;
+  QTimer tickTimer_;
+};
@@ -1,46 +1,213 @@
 #include "PreviewPipeline.h"
 #include <QDebug>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/audio/audio.h>
+#include <gst/video/video.h>
 #include <gst/video/videooverlay.h>
 #include <gst/gstmessage.h>
 #include <gst/gst.h>
 #include <glib-object.h>
+#include "scopes/ScopeKernels.h"
+#include "trace/Trace.h"
+
+// Scopes run on a fixed-size proxy at a capped rate, so their cost per source
+// is the same whatever the camera resolution.
+static constexpr int kScopeProxyWidth = 320;
+static constexpr int kScopeProxyHeight = 180;
+static constexpr int kScopeMaxFps = 15;
+
+// Watchdog limits for the source branches. Audio arrives every ~10 ms and
+// video at 5+ fps even in low light, so these only trip on real stalls.
+static constexpr int kVideoStallMs = 500;
+static constexpr int kAudioStallMs = 200;
+
+// Engine output is stamped with capture time but pushed up to one capture
+// buffer (~10 ms) plus one engine period later; the output branch reports this
+// as latency so its sinks schedule against the capture clock without drops.
+static constexpr gint64 kEngineOutputLatencyNs = 40 * GST_MSECOND;
+
+// Everything engineFormat() maps; any rate and channel count.
+static constexpr const char* kEngineCaptureCaps =
+    "audio/x-raw, layout=(string){ interleaved, non-interleaved }, format=(string){ U8, "
+    "S16LE, S16BE, S24LE, S24BE, S24_32LE, S24_32BE, S32LE, S32BE, F32LE, F32BE, F64LE, F64BE }";
 
 PreviewPipeline::PreviewPipeline() {
-  busTimer_.setInterval(30);
-  connect(&busTimer_, &QTimer::timeout, this, &PreviewPipeline::pollBus);
+  if (qEnvironmentVariable("STREAMMATRIX_AUDIO_CONVERT") == "chain") {
+    audioMode_ = AudioConversionMode::PerSourceChain;
+  }
+  supervisor_.setMessageHandler([this](GstMessage* msg) { handleBusMessage(msg); });
 }
 
 PreviewPipeline::~PreviewPipeline() {
   stop();
+  audioEngine_.stop();
 }
 
 void PreviewPipeline::stop() {
-  busTimer_.stop();
-  if (pipeline_) {
-    gst_element_set_state(pipeline_, GST_STATE_NULL);
+  // Detach from the engine first so its thread no longer touches engineSrc_
+  if (engineSourceId_ >= 0) {
+    audioEngine_.removeSource(engineSourceId_);
+    engineSourceId_ = -1;
+  }
+  supervisor_.clear();
+  if (videoDevice_) {
+    gst_object_unref(videoDevice_);
+    videoDevice_ = nullptr;
+  }
+  if (audioDevice_) {
+    gst_object_unref(audioDevice_);
+    audioDevice_ = nullptr;
+  }
+  videoSink_ = nullptr;
+  scopeBuffer_.reset();
+}
+
+static GstPadProbeReturn traceBufferProbe(GstPad*, GstPadProbeInfo*, gpointer name) {
+  SM_TRACE_INSTANT(trace::kFine, "probe", static_cast<const char*>(name));
+  return GST_PAD_PROBE_OK;
+}
+
+static void addTraceProbe(GstElement* element, const char* padName, const char* eventName) {
+  if constexpr (trace::compiledIn(trace::kFine)) {
+    GstPad* pad = gst_element_get_static_pad(element, padName);
+    if (!pad) return;
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, traceBufferProbe,
+                      const_cast<char*>(eventName), nullptr);
+    gst_object_unref(pad);
+  }
+}
+
+// Runs on the scope branch streaming thread. Never blocks on the UI: if the
+// UI still holds the free slot, the frame is simply skipped.
+static GstFlowReturn onScopeSample(GstAppSink* sink, gpointer user_data) {
+  auto* buffer = static_cast<ScopeBuffer*>(user_data);
+  GstSample* sample = gst_app_sink_pull_sample(sink);
+  if (!sample) return GST_FLOW_EOS;
+  SM_TRACE_SCOPE(trace::kCoarse, "scopes", "computeScopes");
+
+  GstVideoInfo info;
+  GstBuffer* buf = gst_sample_get_buffer(sample);
+  GstCaps* caps = gst_sample_get_caps(sample);
+  if (buf && caps && gst_video_info_from_caps(&info, caps)) {
+    GstVideoFrame frame;
+    if (gst_video_frame_map(&frame, &info, buf, GST_MAP_READ)) {
+      if (ScopeFrame* out = buffer->beginWrite()) {
+        computeScopes(static_cast<const uint8_t*>(GST_VIDEO_FRAME_PLANE_DATA(&frame, 0)),
+                      GST_VIDEO_FRAME_WIDTH(&frame), GST_VIDEO_FRAME_HEIGHT(&frame),
+                      GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0), *out);
+        buffer->publish();
+      } else {
+        SM_TRACE_INSTANT(trace::kCoarse, "scopes", "frame-dropped");
+      }
+      gst_video_frame_unmap(&frame);
+    }
   }
-  if(atee_){
-    if(atee_src1_){
-      gst_element_release_request_pad(atee_, atee_src1_);
-      gst_object_unref(atee_src1_);
-      atee_src1_ = nullptr;
+  gst_sample_unref(sample);
+  return GST_FLOW_OK;
+}
+
+static bool engineFormat(const GstAudioInfo& info, AudioInputFormat& fmt) {
+  switch (GST_AUDIO_INFO_FORMAT(&info)) {
+    case GST_AUDIO_FORMAT_U8: fmt.format = SampleFormat::U8; break;
+    case GST_AUDIO_FORMAT_S16LE: case GST_AUDIO_FORMAT_S16BE: fmt.format = SampleFormat::S16; break;
+    case GST_AUDIO_FORMAT_S24LE: case GST_AUDIO_FORMAT_S24BE: fmt.format = SampleFormat::S24; break;
+    case GST_AUDIO_FORMAT_S24_32LE: case GST_AUDIO_FORMAT_S24_32BE: fmt.format = SampleFormat::S24_32; break;
+    case GST_AUDIO_FORMAT_S32LE: case GST_AUDIO_FORMAT_S32BE: fmt.format = SampleFormat::S32; break;
+    case GST_AUDIO_FORMAT_F32LE: case GST_AUDIO_FORMAT_F32BE: fmt.format = SampleFormat::F32; break;
+    case GST_AUDIO_FORMAT_F64LE: case GST_AUDIO_FORMAT_F64BE: fmt.format = SampleFormat::F64; break;
+    default: return false;
+  }
+  fmt.channels = GST_AUDIO_INFO_CHANNELS(&info);
+  fmt.rate = GST_AUDIO_INFO_RATE(&info);
+  fmt.swapped = GST_AUDIO_INFO_WIDTH(&info) > 8 && GST_AUDIO_INFO_ENDIANNESS(&info) != G_BYTE_ORDER;
+  return true;
+}
+
+// Whether the engine can take the device's output without a converter in
+// front. Devices that do not report caps are assumed to be able to.
+static bool engineAcceptsDevice(const GstDevice* dev) {
+  if (!dev) return true;  // audiotestsrc
+  GstCaps* caps = gst_device_get_caps(const_cast<GstDevice*>(dev));
+  if (!caps) return true;
+  GstCaps* accepted = gst_caps_from_string(kEngineCaptureCaps);
+  const bool ok = gst_caps_can_intersect(caps, accepted);
+  gst_caps_unref(accepted);
+  gst_caps_unref(caps);
+  return ok;
+}
+
+// Runs on the capture streaming thread; only stages raw bytes in the engine.
+GstFlowReturn PreviewPipeline::onEngineCaptureSample(GstAppSink* sink, gpointer user_data) {
+  auto* self = static_cast<PreviewPipeline*>(user_data);
+  GstSample* sample = gst_app_sink_pull_sample(sink);
+  if (!sample) return GST_FLOW_EOS;
+
+  GstAudioInfo info;
+  AudioInputFormat fmt;
+  GstBuffer* buf = gst_sample_get_buffer(sample);
+  GstCaps* caps = gst_sample_get_caps(sample);
+  if (buf && caps && gst_audio_info_from_caps(&info, caps) && engineFormat(info, fmt)) {
+    GstAudioBuffer abuf;
+    if (gst_audio_buffer_map(&abuf, &info, buf, GST_MAP_READ)) {
+      const int id = self->engineSourceId_;
+      const size_t frames = GST_AUDIO_BUFFER_N_SAMPLES(&abuf);
+      const uint64_t pts = GST_BUFFER_PTS_IS_VALID(buf) ? GST_BUFFER_PTS(buf)
+                                                         : AudioConversionEngine::kNoTimestamp;
+      if (GST_AUDIO_INFO_LAYOUT(&info) == GST_AUDIO_LAYOUT_INTERLEAVED) {
+        self->audioEngine_.push(id, fmt, abuf.planes[0], frames, pts);
+      } else {
+        self->audioEngine_.pushPlanar(id, fmt, abuf.planes, frames, pts);
+      }
+      gst_audio_buffer_unmap(&abuf);
     }
-    if(atee_src2_){
-      gst_element_release_request_pad(atee_, atee_src2_);
-      gst_object_unref(atee_src2_);
-      atee_src2_ = nullptr;
+  }
+  gst_sample_unref(sample);
+  return GST_FLOW_OK;
+}
+
+// Runs on the engine thread: interleave the planar result for downstream.
+// Capture and output branches share a base time, so the engine's timestamps
+// (capture running time) are valid as-is in the output branch.
+void PreviewPipeline::pushEngineOutput(const float* const* planes, int channels, size_t frames,
+                                       uint64_t ptsNs, uint64_t durationNs) {
+  std::lock_guard<std::mutex> lock(engineSrcMtx_);
+  if (!engineSrc_ || channels <= 0 || frames == 0) return;
+
+  if (channels != engineSrcChannels_) {
+    GstCaps* caps = gst_caps_new_simple("audio/x-raw",
+                                        "format", G_TYPE_STRING, GST_AUDIO_NE(F32),
+                                        "layout", G_TYPE_STRING, "interleaved",
+                                        "rate", G_TYPE_INT, audioEngine_.outputRate(),
+                                        "channels", G_TYPE_INT, channels,
+                                        nullptr);
+    if (channels > 2) {
+      // unpositioned; level and the monitor sink only need the count
+      gst_caps_set_simple(caps, "channel-mask", GST_TYPE_BITMASK, guint64(0), nullptr);
     }
+    gst_app_src_set_caps(GST_APP_SRC(engineSrc_), caps);
+    gst_caps_unref(caps);
+    engineSrcChannels_ = channels;
+  }
+
+  GstBuffer* buf = gst_buffer_new_allocate(nullptr, frames * channels * sizeof(float), nullptr);
+  GstMapInfo map;
+  if (!gst_buffer_map(buf, &map, GST_MAP_WRITE)) {
+    gst_buffer_unref(buf);
+    return;
   }
-  if (bus_) {
-    gst_object_unref(bus_);
-    bus_ = nullptr;
+  auto* out = reinterpret_cast<float*>(map.data);
+  for (size_t i = 0; i < frames; ++i) {
+    for (int c = 0; c < channels; ++c) {
+      out[i * channels + c] = planes[c][i];
+    }
   }
-  if (pipeline_) {
-    gst_object_unref(pipeline_);
-    pipeline_ = nullptr;
+  gst_buffer_unmap(buf, &map);
+  if (ptsNs != AudioConversionEngine::kNoTimestamp) {
+    GST_BUFFER_PTS(buf) = ptsNs;
+    GST_BUFFER_DURATION(buf) = durationNs;
   }
-  videoSink_ = nullptr;
-  level_ = nullptr;
+  gst_app_src_push_buffer(GST_APP_SRC(engineSrc_), buf);
 }
 
 static GstElement* elementFromDevice(const GstDevice* dev,
@@ -51,24 +218,44 @@ static GstElement* elementFromDevice(const GstDevice* dev,
   return nullptr;
 }
 
-void PreviewPipeline::start(const GstDevice* video_dev,
-                            const GstDevice* audio_dev,
-                            VideoWidget* video_widget,
-                            AudioMeterWidget* meters) {
-  stop();  // Clean previous pipeline
+// Adds the source to the pipeline and returns the element to link from. On
+// restarts the caps it negotiated before are pinned right behind it, so the
+// device does not have to be probed again.
+static GstElement* addSource(GstElement* pipeline, GstElement* src, const GstCaps* cachedCaps,
+                             const char* capsName) {
+  gst_bin_add(GST_BIN(pipeline), src);
+  if (!cachedCaps) return src;
 
-  videoWidget_ = video_widget;
-  meters_ = meters;
+  GstElement* pinned = gst_element_factory_make("capsfilter", capsName);
+  g_object_set(pinned, "caps", cachedCaps, nullptr);
+  gst_bin_add(GST_BIN(pipeline), pinned);
+  if (!gst_element_link(src, pinned)) {
+    qWarning() << "Failed to pin cached caps on" << capsName;
+  }
+  return pinned;
+}
+
+// Links a fresh request pad of tee to sink's sink pad. The tee keeps the pad
+// and releases it when the pipeline is disposed.
+static void linkTeeBranch(GstElement* tee, GstElement* sink) {
+  GstPad* tee_src = gst_element_request_pad_simple(tee, "src_%u");
+  GstPad* sink_pad = gst_element_get_static_pad(sink, "sink");
+  gst_pad_link(tee_src, sink_pad);
+  gst_object_unref(sink_pad);
+  gst_object_unref(tee_src);
+}
 
-  // 1. CREATE ALL ELEMENTS
-  // ======================
-  pipeline_ = gst_pipeline_new("preview-pipeline");
+GstElement* PreviewPipeline::buildVideoBranch(const GstCaps* cachedCaps) {
+  GstElement* pipeline = gst_pipeline_new("video-branch");
 
-  // Video elements
-  GstElement* vsrc = elementFromDevice(video_dev, "vsrc");
+  GstElement* vsrc = elementFromDevice(videoDevice_, "vsrc");
   if (!vsrc) {
     vsrc = gst_element_factory_make("videotestsrc", "vsrc");
+    g_object_set(vsrc, "is-live", TRUE, nullptr);
   }
+  GstElement* vhead = addSource(pipeline, vsrc, cachedCaps, "vsrc_caps");
+
+  GstElement* vtee = gst_element_factory_make("tee", "vtee");
   GstElement* vqueue = gst_element_factory_make("queue", "vqueue");
   GstElement* vconv = gst_element_factory_make("videoconvert", "vconv");
   videoSink_ = gst_element_factory_make("glimagesink", "vsink");
@@ -76,50 +263,75 @@ void PreviewPipeline::start(const GstDevice* video_dev,
     videoSink_ = gst_element_factory_make("autovideosink", "vsink");
   }
 
-  // Audio elements
-  GstElement* asrc = elementFromDevice(audio_dev, "asrc");
-  if (!asrc) {
-    asrc = gst_element_factory_make("audiotestsrc", "asrc");
-  }
-  GstElement* capture_queue = gst_element_factory_make("queue", "capture_queue");
-  GstElement* aconv = gst_element_factory_make("audioconvert", "aconv");
-  GstElement* ares = gst_element_factory_make("audioresample", "ares");
-  atee_ = gst_element_factory_make("tee", "atee");
-  GstElement* meter_queue = gst_element_factory_make("queue", "meter_queue");
-  level_ = gst_element_factory_make("level", "level");
-  GstElement* asink = gst_element_factory_make("fakesink", "asink");
-  GstElement* mon_queue = gst_element_factory_make("queue", "mon_queue");
-  GstElement* monitor = gst_element_factory_make("autoaudiosink", "monitor");
+  // Scope branch: decimated, downscaled RGBx proxy
+  GstElement* scope_queue = gst_element_factory_make("queue", "scope_queue");
+  GstElement* scope_rate = gst_element_factory_make("videorate", "scope_rate");
+  GstElement* scope_scale = gst_element_factory_make("videoscale", "scope_scale");
+  GstElement* scope_conv = gst_element_factory_make("videoconvert", "scope_conv");
+  GstElement* scope_caps = gst_element_factory_make("capsfilter", "scope_caps");
+  GstElement* scope_sink = gst_element_factory_make("appsink", "scope_sink");
 
-  // Configure elements
-  g_object_set(level_, "interval", guint64(50000000), "post-messages", TRUE, nullptr);
-  g_object_set(capture_queue, "leaky", 2, "max-size-buffers", 0, "max-size-time", 0, nullptr);
-  g_object_set(asink, "sync", FALSE, nullptr);
   g_object_set(videoSink_, "sync", FALSE, nullptr);
+  g_object_set(scope_queue, "leaky", 2, "max-size-buffers", 1, "max-size-time", 0,
+               "max-size-bytes", 0, nullptr);
+  g_object_set(scope_rate, "drop-only", TRUE, "max-rate", kScopeMaxFps, nullptr);
+  GstCaps* proxy_caps = gst_caps_new_simple("video/x-raw",
+                                            "format", G_TYPE_STRING, "RGBx",
+                                            "width", G_TYPE_INT, kScopeProxyWidth,
+                                            "height", G_TYPE_INT, kScopeProxyHeight,
+                                            nullptr);
+  g_object_set(scope_caps, "caps", proxy_caps, nullptr);
+  gst_caps_unref(proxy_caps);
+  g_object_set(scope_sink, "sync", FALSE, "max-buffers", 1, "drop", TRUE, nullptr);
+  GstAppSinkCallbacks scope_callbacks = {};
+  scope_callbacks.new_sample = onScopeSample;
+  gst_app_sink_set_callbacks(GST_APP_SINK(scope_sink), &scope_callbacks,
+                             scopeBuffer_.get(), nullptr);
 
-  // 2. ADD ALL ELEMENTS TO THE PIPELINE (ONCE!)
-  // ===========================================
-  gst_bin_add_many(GST_BIN(pipeline_),
-                   vsrc, vqueue, vconv, videoSink_,
-                   asrc, capture_queue, aconv, ares, atee_,
-                   meter_queue, level_, asink,
-                   mon_queue, monitor,
+  gst_bin_add_many(GST_BIN(pipeline),
+                   vtee, vqueue, vconv, videoSink_,
+                   scope_queue, scope_rate, scope_scale, scope_conv, scope_caps, scope_sink,
                    nullptr);
 
-  // 3. LINK THE ELEMENTS
-  // ====================
-  // Link video branch
-  if (!gst_element_link_many(vsrc, vqueue, vconv, videoSink_, nullptr)) {
+  // Link video source to its tee, and the display branch
+  if (!gst_element_link(vhead, vtee)) {
+    qWarning() << "Failed to link video source";
+  }
+  if (!gst_element_link_many(vqueue, vconv, videoSink_, nullptr)) {
     qWarning() << "Failed to link video elements";
   }
 
-  // Link main audio branch up to the tee
-  if (!gst_element_link_many(asrc, capture_queue, aconv, ares, atee_, nullptr)) {
-    qWarning() << "Failed to link main audio chain";
+  // Link scope branch
+  if (!gst_element_link_many(scope_queue, scope_rate, scope_scale, scope_conv,
+                             scope_caps, scope_sink, nullptr)) {
+    qWarning() << "Failed to link scope branch";
   }
 
+  linkTeeBranch(vtee, vqueue);
+  linkTeeBranch(vtee, scope_queue);
+
+  addTraceProbe(videoSink_, "sink", "video-buffer");
+  return pipeline;
+}
+
+// atee ! meter and monitor branches; returns the tee to link into.
+GstElement* PreviewPipeline::addAudioOutputs(GstElement* pipeline) {
+  GstElement* atee = gst_element_factory_make("tee", "atee");
+  GstElement* meter_queue = gst_element_factory_make("queue", "meter_queue");
+  GstElement* level = gst_element_factory_make("level", "level");
+  GstElement* asink = gst_element_factory_make("fakesink", "asink");
+  GstElement* mon_queue = gst_element_factory_make("queue", "mon_queue");
+  GstElement* monitor = gst_element_factory_make("autoaudiosink", "monitor");
+
+  g_object_set(level, "interval", guint64(50000000), "post-messages", TRUE, nullptr);
+  g_object_set(asink, "sync", FALSE, nullptr);
+
+  gst_bin_add_many(GST_BIN(pipeline),
+                   atee, meter_queue, level, asink, mon_queue, monitor,
+                   nullptr);
+
   // Link meter branch
-  if (!gst_element_link_many(meter_queue, level_, asink, nullptr)) {
+  if (!gst_element_link_many(meter_queue, level, asink, nullptr)) {
     qWarning() << "Failed to link meter branch";
   }
 
@@ -128,23 +340,142 @@ void PreviewPipeline::start(const GstDevice* video_dev,
     qWarning() << "Failed to link monitor branch";
   }
 
-  // Request tee pads and link them to the branches
-  atee_src1_ = gst_element_request_pad_simple(atee_, "src_%u");
-  GstPad* meter_sink_pad = gst_element_get_static_pad(meter_queue, "sink");
-  gst_pad_link(atee_src1_, meter_sink_pad);
-  gst_object_unref(meter_sink_pad);
-
-  atee_src2_ = gst_element_request_pad_simple(atee_, "src_%u");
-  GstPad* mon_sink_pad = gst_element_get_static_pad(mon_queue, "sink");
-  gst_pad_link(atee_src2_, mon_sink_pad);
-  gst_object_unref(mon_sink_pad);
-
-  // 4. START THE PIPELINE
-  // =====================
-  bus_ = gst_element_get_bus(pipeline_);
-  gst_element_set_state(pipeline_, GST_STATE_PLAYING);
-  setOverlayIfPossible();
-  busTimer_.start();
+  linkTeeBranch(atee, meter_queue);
+  linkTeeBranch(atee, mon_queue);
+
+  addTraceProbe(atee, "sink", "audio-buffer");
+  return atee;
+}
+
+static GstElement* makeAudioSource(const GstDevice* dev) {
+  GstElement* asrc = elementFromDevice(dev, "asrc");
+  if (!asrc) {
+    asrc = gst_element_factory_make("audiotestsrc", "asrc");
+    g_object_set(asrc, "is-live", TRUE, nullptr);
+  }
+  return asrc;
+}
+
+// Engine mode, source side: asrc ! capture_queue ! appsink -> engine
+GstElement* PreviewPipeline::buildAudioCaptureBranch(const GstCaps* cachedCaps) {
+  GstElement* pipeline = gst_pipeline_new("audio-capture-branch");
+  GstElement* ahead = addSource(pipeline, makeAudioSource(audioDevice_), cachedCaps, "asrc_caps");
+
+  GstElement* capture_queue = gst_element_factory_make("queue", "capture_queue");
+  GstElement* engine_sink = gst_element_factory_make("appsink", "engine_sink");
+
+  g_object_set(capture_queue, "leaky", 2, "max-size-buffers", 0, "max-size-time", 0, nullptr);
+  GstCaps* engine_caps = gst_caps_from_string(kEngineCaptureCaps);
+  g_object_set(engine_sink, "caps", engine_caps, "sync", FALSE, nullptr);
+  gst_caps_unref(engine_caps);
+  GstAppSinkCallbacks engine_callbacks = {};
+  engine_callbacks.new_sample = &PreviewPipeline::onEngineCaptureSample;
+  gst_app_sink_set_callbacks(GST_APP_SINK(engine_sink), &engine_callbacks, this, nullptr);
+
+  gst_bin_add_many(GST_BIN(pipeline), capture_queue, engine_sink, nullptr);
+  if (!gst_element_link_many(ahead, capture_queue, engine_sink, nullptr)) {
+    qWarning() << "Failed to link main audio chain";
+  }
+  return pipeline;
+}
+
+// Engine mode, output side: appsrc <- engine, then the meter/monitor tee
+GstElement* PreviewPipeline::buildAudioOutputBranch() {
+  GstElement* pipeline = gst_pipeline_new("audio-output-branch");
+  GstElement* engine_src = gst_element_factory_make("appsrc", "engine_src");
+  g_object_set(engine_src, "is-live", TRUE, "format", GST_FORMAT_TIME,
+               "min-latency", kEngineOutputLatencyNs, nullptr);
+  gst_bin_add(GST_BIN(pipeline), engine_src);
+
+  GstElement* atee = addAudioOutputs(pipeline);
+  if (!gst_element_link(engine_src, atee)) {
+    qWarning() << "Failed to link engine output";
+  }
+
+  std::lock_guard<std::mutex> lock(engineSrcMtx_);
+  engineSrc_ = engine_src;
+  engineSrcChannels_ = 0;
+  return pipeline;
+}
+
+// Fallback: asrc ! capture_queue ! audioconvert ! audioresample ! tee
+GstElement* PreviewPipeline::buildAudioChainBranch(const GstCaps* cachedCaps) {
+  GstElement* pipeline = gst_pipeline_new("audio-branch");
+  GstElement* ahead = addSource(pipeline, makeAudioSource(audioDevice_), cachedCaps, "asrc_caps");
+
+  GstElement* capture_queue = gst_element_factory_make("queue", "capture_queue");
+  GstElement* aconv = gst_element_factory_make("audioconvert", "aconv");
+  GstElement* ares = gst_element_factory_make("audioresample", "ares");
+  g_object_set(capture_queue, "leaky", 2, "max-size-buffers", 0, "max-size-time", 0, nullptr);
+  gst_bin_add_many(GST_BIN(pipeline), capture_queue, aconv, ares, nullptr);
+
+  GstElement* atee = addAudioOutputs(pipeline);
+  if (!gst_element_link_many(ahead, capture_queue, aconv, ares, atee, nullptr)) {
+    qWarning() << "Failed to link main audio chain";
+  }
+  return pipeline;
+}
+
+void PreviewPipeline::start(const GstDevice* video_dev,
+                            const GstDevice* audio_dev,
+                            VideoWidget* video_widget,
+                            AudioMeterWidget* meters,
+                            ScopeWidget* scopes) {
+  stop();  // Clean previous branches
+
+  videoWidget_ = video_widget;
+  meters_ = meters;
+  scopeBuffer_ = scopes ? scopes->buffer() : std::make_shared<ScopeBuffer>();
+  videoDevice_ = video_dev ? GST_DEVICE(gst_object_ref(const_cast<GstDevice*>(video_dev))) : nullptr;
+  audioDevice_ = audio_dev ? GST_DEVICE(gst_object_ref(const_cast<GstDevice*>(audio_dev))) : nullptr;
+
+  PipelineSupervisor::BranchSpec video;
+  video.name = "video";
+  video.build = [this](const GstCaps* caps) { return buildVideoBranch(caps); };
+  video.watchElement = "vsrc";
+  video.stallTimeoutMs = kVideoStallMs;
+  video.started = [this] { setOverlayIfPossible(); };
+  video.stopping = [this] { videoSink_ = nullptr; };
+  supervisor_.addBranch(std::move(video));
+
+  bool useEngine = audioMode_ == AudioConversionMode::Engine;
+  if (useEngine && !engineAcceptsDevice(audioDevice_)) {
+    // e.g. S20 or U16-only hardware: keep audioconvert for this source
+    qInfo() << "Audio device has no format the conversion engine decodes; using audioconvert";
+    useEngine = false;
+  }
+
+  if (useEngine) {
+    engineSourceId_ = audioEngine_.addSource(
+        [this](const float* const* planes, int channels, size_t frames, uint64_t pts,
+               uint64_t duration) { pushEngineOutput(planes, channels, frames, pts, duration); });
+    audioEngine_.start();
+
+    PipelineSupervisor::BranchSpec capture;
+    capture.name = "audio-capture";
+    capture.build = [this](const GstCaps* caps) { return buildAudioCaptureBranch(caps); };
+    capture.watchElement = "asrc";
+    capture.stallTimeoutMs = kAudioStallMs;
+    supervisor_.addBranch(std::move(capture));
+
+    // Its input is the engine, so a stall here means the capture branch
+    // stalled; only bus errors restart it.
+    PipelineSupervisor::BranchSpec output;
+    output.name = "audio-output";
+    output.build = [this](const GstCaps*) { return buildAudioOutputBranch(); };
+    output.stopping = [this] {
+      std::lock_guard<std::mutex> lock(engineSrcMtx_);
+      engineSrc_ = nullptr;
+    };
+    supervisor_.addBranch(std::move(output));
+  } else {
+    PipelineSupervisor::BranchSpec audio;
+    audio.name = "audio";
+    audio.build = [this](const GstCaps* caps) { return buildAudioChainBranch(caps); };
+    audio.watchElement = "asrc";
+    audio.stallTimeoutMs = kAudioStallMs;
+    supervisor_.addBranch(std::move(audio));
+  }
 }
 
 void PreviewPipeline::setOverlayIfPossible() {
@@ -160,23 +491,16 @@ void PreviewPipeline::setOverlayIfPossible() {
 }
 
 void PreviewPipeline::handleLevelMessage(GstMessage* msg) {
-  qDebug() << "LEVEL MSG";
+  SM_TRACE_SCOPE(trace::kCoarse, "meter", "handleLevelMessage");
   const GstStructure* s = gst_message_get_structure(msg);
   if(!s) return;
-  char* structure_string = gst_structure_to_string(s);
-  qDebug() << "Full Message Structure: " << structure_string;
-  g_free(structure_string);
   const GValue* peaks = gst_structure_get_value(s, "peak");
   if(!peaks) return;
-  const char* type_name = G_VALUE_TYPE_NAME(peaks);
-  if(!type_name) return;
-  qDebug() << "PEAK TYPE " << type_name;
 
 
   QVector<float> dbLevels;
   int n = 0;
   if (GST_VALUE_HOLDS_LIST(peaks)){
-    qDebug() << "In ValueList logic";
     n = gst_value_list_get_size(peaks);
     dbLevels.reserve(n);
     for(int i = 0; i < n; ++i){
@@ -192,7 +516,6 @@ void PreviewPipeline::handleLevelMessage(GstMessage* msg) {
       }
     }
   } else if (GST_VALUE_HOLDS_ARRAY(peaks)){
-    qDebug() << "In GstArray logic";
     int n = gst_value_array_get_size(peaks);
     dbLevels.reserve(n);
     for(int i = 0; i < n; ++i){
@@ -208,7 +531,6 @@ void PreviewPipeline::handleLevelMessage(GstMessage* msg) {
       }
     }
   } else if(G_VALUE_HOLDS(peaks, G_TYPE_VALUE_ARRAY)){
-    qDebug() << "Using GLib GValueArray parsing";
     GValueArray* arr = reinterpret_cast<GValueArray*>(g_value_get_boxed(peaks));
     if(!arr){
       qWarning() << "GValueArray is null";
@@ -236,52 +558,22 @@ void PreviewPipeline::handleLevelMessage(GstMessage* msg) {
 
 
   } else{
-    qDebug() << "unsupported peak value type";
+    SM_TRACE_INSTANT(trace::kCoarse, "meter", "unsupported-peak-type");
     return;
   }
 
   if (meters_) {
     meters_->setPeakLevels(dbLevels);
-    qDebug() << "Setting meters_ " << dbLevels;
-  }
-  else{
-    qDebug() << "No meters_ to set";
   }
 }
 
-void PreviewPipeline::pollBus() {
-  if (!bus_) return;
-
-  while (true) {
-    GstMessage* msg = gst_bus_pop(bus_);
-    if (!msg) break;
-
-    switch (GST_MESSAGE_TYPE(msg)) {
-      case GST_MESSAGE_ERROR: {
-        GError* err = nullptr;
-        gchar* dbg = nullptr;
-        gst_message_parse_error(msg, &err, &dbg);
-        qWarning() << "GStreamer error:" << (err ? err->message : "unknown");
-        if (dbg) {
-          qWarning() << "Debug:" << dbg;
-          g_free(dbg);
-        }
-        if (err) g_error_free(err);
-        break;
-      }
-      case GST_MESSAGE_ELEMENT: {
-        const GstStructure* s = gst_message_get_structure(msg);
-        if (s && gst_structure_has_name(s, "prepare-window-handle")) {
-          setOverlayIfPossible();
-        } else if (s && gst_structure_has_name(s, "level")) {
-          handleLevelMessage(msg);
-        }
-        break;
-      }
-      default:
-        break;
-    }
-
-    gst_message_unref(msg);
+// Bus messages of every branch that the supervisor does not handle itself.
+void PreviewPipeline::handleBusMessage(GstMessage* msg) {
+  if (GST_MESSAGE_TYPE(msg) != GST_MESSAGE_ELEMENT) return;
+  const GstStructure* s = gst_message_get_structure(msg);
+  if (s && gst_structure_has_name(s, "prepare-window-handle")) {
+    setOverlayIfPossible();
+  } else if (s && gst_structure_has_name(s, "level")) {
+    handleLevelMessage(msg);
   }
-}
\ No newline at end of file
+}
@@ -1,9 +1,22 @@
 #pragma once
 #include <QPointer>
-#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include "audio/AudioConversionEngine.h"
 #include "gui/AudioMeterWidget.h"
+#include "gui/ScopeWidget.h"
 #include "gui/VideoWidget.h"
+#include "pipeline/PipelineSupervisor.h"
+#include "scopes/ScopeBuffer.h"
+
+// How captured audio reaches the internal F32 / 48 kHz format.
+enum class AudioConversionMode {
+  Engine,         // shared batched AudioConversionEngine (default)
+  PerSourceChain  // audioconvert ! audioresample per source
+};
 
 class PreviewPipeline : public QObject {
   Q_OBJECT
@@ -14,26 +27,48 @@ public:
   void start(const GstDevice* videoDev,
              const GstDevice* audioDev,
              VideoWidget* videoWidget,
-             AudioMeterWidget* meters);
+             AudioMeterWidget* meters,
+             ScopeWidget* scopes);
 
   void stop();
 
-private slots:
-  void pollBus();
+  // Takes effect on the next start(). Defaults to Engine unless
+  // STREAMMATRIX_AUDIO_CONVERT=chain is set in the environment. A device with
+  // no format the engine decodes gets the chain regardless.
+  void setAudioConversionMode(AudioConversionMode mode) { audioMode_ = mode; }
+
+  PipelineSupervisor& supervisor() { return supervisor_; }
 
 private:
-  GstElement* atee_{nullptr};
-  GstPad* atee_src1_{nullptr};
-  GstPad* atee_src2_{nullptr};
-  GstElement* pipeline_{nullptr};
-  GstElement* videoSink_{nullptr};
-  GstElement* level_{nullptr};
-  GstBus* bus_{nullptr};
+  GstDevice* videoDevice_{nullptr};  // ref'd while running, branches are rebuilt from it
+  GstDevice* audioDevice_{nullptr};
+  GstElement* videoSink_{nullptr};   // in the current video branch instance
 
   QPointer<VideoWidget> videoWidget_;
   QPointer<AudioMeterWidget> meters_;
-  QTimer busTimer_;
+  std::shared_ptr<ScopeBuffer> scopeBuffer_;  // written from the scope branch streaming thread
+
+  PipelineSupervisor supervisor_;
+
+  AudioConversionMode audioMode_{AudioConversionMode::Engine};
+  AudioConversionEngine audioEngine_;
+  std::atomic<int> engineSourceId_{-1};  // read by the capture streaming thread
+  std::mutex engineSrcMtx_;         // the output branch can be rebuilt under the engine thread
+  GstElement* engineSrc_{nullptr};  // appsrc fed from the engine thread
+  int engineSrcChannels_{0};
+
+  static GstFlowReturn onEngineCaptureSample(GstAppSink* sink, gpointer user_data);
+  void pushEngineOutput(const float* const* planes, int channels, size_t frames,
+                        uint64_t ptsNs, uint64_t durationNs);
+
+  // Branch builders; each returns a new pipeline for the supervisor
+  GstElement* buildVideoBranch(const GstCaps* cachedCaps);
+  GstElement* buildAudioCaptureBranch(const GstCaps* cachedCaps);
+  GstElement* buildAudioOutputBranch();
+  GstElement* buildAudioChainBranch(const GstCaps* cachedCaps);
+  GstElement* addAudioOutputs(GstElement* pipeline);
 
+  void handleBusMessage(GstMessage* msg);
   void setOverlayIfPossible();
   void handleLevelMessage(GstMessage* msg);
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "ScopeBuffer.h"
+
+// All atomics use seq_cst: the reader's pin store and the writer's front
+// store must be totally ordered with the loads that follow them, otherwise
+// the writer could start overwriting the slot the reader just pinned.
+
+ScopeFrame* ScopeBuffer::beginWrite() {
+  const int target = 1 - front_.load();
+  if (pinned_.load() == target) return nullptr;
+  writeSlot_ = target;
+  return &slots_[target];
+}
+
+void ScopeBuffer::publish() {
+  if (writeSlot_ < 0) return;
+  slots_[writeSlot_].seq = published_.load() + 1;
+  front_.store(writeSlot_);
+  published_.fetch_add(1);
+  writeSlot_ = -1;
+}
+
+const ScopeFrame* ScopeBuffer::acquire() {
+  int f = front_.load();
+  while (true) {
+    pinned_.store(f);
+    const int again = front_.load();
+    if (again == f) break;
+    f = again;
+  }
+  if (published_.load() == 0) {
+    pinned_.store(-1);
+    return nullptr;
+  }
+  return &slots_[f];
+}
+
+void ScopeBuffer::release() {
+  pinned_.store(-1);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include "scopes/ScopeKernels.h"
+
+// Double buffer between the streaming thread that computes scopes and the UI
+// thread that draws them. Neither side ever waits: the writer always fills
+// the slot that is not published, and if the reader is still holding that
+// slot from an earlier publish the writer drops the frame instead.
+class ScopeBuffer {
+public:
+  // Writer side (one streaming thread). Returns nullptr if the frame must be
+  // dropped; otherwise fill the slot and call publish().
+  ScopeFrame* beginWrite();
+  void publish();
+
+  // Reader side (one UI thread). Returns nullptr before the first publish.
+  // The frame stays valid until release().
+  const ScopeFrame* acquire();
+  void release();
+
+private:
+  std::array<ScopeFrame, 2> slots_;
+  std::atomic<int> front_{0};
+  std::atomic<int> pinned_{-1};
+  std::atomic<uint64_t> published_{0};
+  int writeSlot_{-1};
+};
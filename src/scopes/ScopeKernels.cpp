@@ -0,0 +1,70 @@
+#include "ScopeKernels.h"
+#include <algorithm>
+
+namespace {
+
+// BT.709, full range, 8.8 fixed point. Each luma row sums to 256 and each
+// chroma row to zero; chroma rounds with 127 rather than 128 so that +128 on
+// a saturated primary lands on 255 instead of wrapping, and no clamping is
+// needed.
+constexpr int kYR = 54, kYG = 183, kYB = 19;
+constexpr int kCbR = -29, kCbG = -99, kCbB = 128;
+constexpr int kCrR = 128, kCrG = -116, kCrB = -12;
+
+inline int lumaOf(int r, int g, int b) {
+  return (kYR * r + kYG * g + kYB * b + 128) >> 8;
+}
+inline int cbOf(int r, int g, int b) {
+  return ((kCbR * r + kCbG * g + kCbB * b + 127) >> 8) + 128;
+}
+inline int crOf(int r, int g, int b) {
+  return ((kCrR * r + kCrG * g + kCrB * b + 127) >> 8) + 128;
+}
+
+}  // namespace
+
+void ScopeFrame::reset(int w, int h) {
+  width = w;
+  height = h;
+  const size_t cols = static_cast<size_t>(std::max(w, 0)) * kLevels;
+  waveform.assign(cols, 0);
+  parade.assign(cols * 3, 0);
+  vectorscope.assign(static_cast<size_t>(kLevels) * kLevels, 0);
+  histogram.assign(static_cast<size_t>(kLevels) * 4, 0);
+}
+
+// Scalar on purpose: per frame the time goes into the bin scatter (nine
+// dependent increments per pixel) and the accumulator clears in reset(), not
+// into the colour-space math, so a vector conversion pass measured no faster.
+void computeScopes(const uint8_t* rgbx, int width, int height, int stride, ScopeFrame& out) {
+  out.reset(width, height);
+  if (!rgbx || width <= 0 || height <= 0) return;
+
+  constexpr int L = ScopeFrame::kLevels;
+  uint16_t* wave = out.waveform.data();
+  uint16_t* paradeR = out.parade.data();
+  uint16_t* paradeG = paradeR + static_cast<size_t>(width) * L;
+  uint16_t* paradeB = paradeG + static_cast<size_t>(width) * L;
+  uint32_t* hist = out.histogram.data();
+  uint32_t* vec = out.vectorscope.data();
+
+  for (int row = 0; row < height; ++row) {
+    const uint8_t* line = rgbx + static_cast<size_t>(row) * stride;
+    for (int x = 0; x < width; ++x) {
+      const int r = line[4 * x + 0];
+      const int g = line[4 * x + 1];
+      const int b = line[4 * x + 2];
+      const int y = lumaOf(r, g, b);
+      const size_t col = static_cast<size_t>(x) * L;
+      ++wave[col + y];
+      ++paradeR[col + r];
+      ++paradeG[col + g];
+      ++paradeB[col + b];
+      ++hist[0 * L + r];
+      ++hist[1 * L + g];
+      ++hist[2 * L + b];
+      ++hist[3 * L + y];
+      ++vec[static_cast<size_t>(crOf(r, g, b)) * L + cbOf(r, g, b)];
+    }
+  }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Scope accumulators for one proxy frame. The proxy has a fixed size, so the
+// cost of computing and drawing scopes does not depend on the source
+// resolution.
+struct ScopeFrame {
+  static constexpr int kLevels = 256;
+
+  int width{0};   // proxy width; waveform/parade have one column per pixel
+  int height{0};
+  uint64_t seq{0};  // bumped on every publish, lets readers skip stale frames
+
+  std::vector<uint16_t> waveform;     // [x * kLevels + luma]
+  std::vector<uint16_t> parade;       // [(c * width + x) * kLevels + value], c = R,G,B
+  std::vector<uint32_t> vectorscope;  // [cr * kLevels + cb]
+  std::vector<uint32_t> histogram;    // [c * kLevels + value], c = R,G,B,Y
+
+  void reset(int w, int h);
+};
+
+// Accumulates all scopes from an RGBx (byte order R,G,B,x) image. Luma and
+// chroma use BT.709 full-range coefficients in 8.8 fixed point.
+void computeScopes(const uint8_t* rgbx, int width, int height, int stride, ScopeFrame& out);
+
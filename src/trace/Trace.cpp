@@ -0,0 +1,301 @@
+#include "Trace.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#define SM_TRACE_HAVE_PTHREAD 1
+#endif
+
+namespace trace {
+namespace {
+
+// 8192 records * 48 bytes = 384 KiB per thread.
+constexpr uint64_t kRingSize = 8192;
+constexpr uint64_t kRingMask = kRingSize - 1;
+static_assert((kRingSize & kRingMask) == 0, "ring size must be a power of two");
+
+// GStreamer spins up new streaming threads on every pipeline restart, so rings
+// of exited threads are recycled once this many exist. A thread that finds no
+// ring free records nothing until one is retired; what it loses is counted.
+constexpr size_t kMaxRings = 64;
+
+struct ThreadRing {
+  std::array<Record, kRingSize> records;
+  std::atomic<uint64_t> head{0};  // next write index; only the owner stores
+  std::atomic<bool> retired{false};
+  uint64_t tid{0};
+  std::string name;  // guarded by Registry::mtx
+};
+
+struct Registry {
+  std::mutex mtx;
+  std::vector<std::unique_ptr<ThreadRing>> rings;
+  uint64_t nextTid{1};
+};
+
+// Intentionally leaked: thread_local destructors may run after static
+// destruction has started.
+Registry& registry() {
+  static Registry* r = new Registry;
+  return *r;
+}
+
+std::atomic<bool> g_enabled{true};
+
+// Retired rings waiting for reuse; lets ringless threads skip the registry
+// lock until there is something to take.
+std::atomic<size_t> g_freeRings{0};
+std::atomic<uint64_t> g_starvedThreads{0};  // threads that ever had no ring
+std::atomic<uint64_t> g_droppedEvents{0};   // events recorded without a ring
+
+std::string osThreadName() {
+#ifdef SM_TRACE_HAVE_PTHREAD
+  char buf[64] = {};
+  if (pthread_getname_np(pthread_self(), buf, sizeof(buf)) == 0 && buf[0]) {
+    return buf;
+  }
+#endif
+  return {};
+}
+
+ThreadRing* acquireRing() {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+
+  ThreadRing* ring = nullptr;
+  if (reg.rings.size() < kMaxRings) {
+    reg.rings.push_back(std::make_unique<ThreadRing>());
+    ring = reg.rings.back().get();
+  } else {
+    for (auto& r : reg.rings) {
+      if (r->retired.load(std::memory_order_acquire)) {
+        ring = r.get();
+        break;
+      }
+    }
+    if (!ring) return nullptr;
+    g_freeRings.fetch_sub(1, std::memory_order_relaxed);
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->retired.store(false, std::memory_order_relaxed);
+  }
+
+  ring->tid = reg.nextTid++;
+  ring->name = osThreadName();
+  if (ring->name.empty()) ring->name = "thread-" + std::to_string(ring->tid);
+  return ring;
+}
+
+struct RingHandle {
+  ThreadRing* ring{nullptr};
+  bool attempted{false};
+  bool starved{false};
+
+  ~RingHandle() {
+    if (!ring) return;
+    ring->retired.store(true, std::memory_order_release);
+    g_freeRings.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+thread_local RingHandle t_handle;
+
+ThreadRing* localRing() {
+  RingHandle& h = t_handle;
+  if (h.ring) return h.ring;
+  // Without a ring, only go back to the registry once another thread retired one.
+  if (h.attempted && g_freeRings.load(std::memory_order_relaxed) == 0) return nullptr;
+  h.attempted = true;
+  h.ring = acquireRing();
+  if (!h.ring && !h.starved) {
+    h.starved = true;
+    g_starvedThreads.fetch_add(1, std::memory_order_relaxed);
+  }
+  return h.ring;
+}
+
+void push(const Record& rec) {
+  ThreadRing* ring = localRing();
+  if (!ring) {
+    g_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const uint64_t h = ring->head.load(std::memory_order_relaxed);
+  ring->records[h & kRingMask] = rec;
+  ring->head.store(h + 1, std::memory_order_release);
+}
+
+// Copies the live part of a ring. Slots the owner may have overwritten while
+// we were copying are discarded using a second read of the head.
+std::vector<Record> snapshot(const ThreadRing& ring) {
+  const uint64_t h1 = ring.head.load(std::memory_order_acquire);
+  const uint64_t n = std::min(h1, kRingSize);
+  std::vector<Record> out;
+  out.reserve(static_cast<size_t>(n));
+  for (uint64_t i = h1 - n; i < h1; ++i) {
+    out.push_back(ring.records[i & kRingMask]);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t h2 = ring.head.load(std::memory_order_relaxed);
+  const uint64_t firstValid = (h2 + 1 > kRingSize) ? h2 + 1 - kRingSize : 0;
+  const uint64_t skip = firstValid > h1 - n ? firstValid - (h1 - n) : 0;
+  out.erase(out.begin(), out.begin() + static_cast<ptrdiff_t>(std::min<uint64_t>(skip, out.size())));
+  return out;
+}
+
+void writeJsonString(std::ostream& out, const char* s) {
+  out << '"';
+  for (; s && *s; ++s) {
+    const char c = *s;
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char esc[8];
+      std::snprintf(esc, sizeof(esc), "\\u%04x", static_cast<unsigned>(c));
+      out << esc;
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+void writeMicros(std::ostream& out, uint64_t ns) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%llu.%03llu",
+                static_cast<unsigned long long>(ns / 1000),
+                static_cast<unsigned long long>(ns % 1000));
+  out << buf;
+}
+
+// JSON has no inf/nan; those counter samples are written as null.
+void writeNumber(std::ostream& out, double v) {
+  if (std::isfinite(v)) {
+    out << v;
+  } else {
+    out << "null";
+  }
+}
+
+long processId() {
+#ifdef SM_TRACE_HAVE_PTHREAD
+  return static_cast<long>(getpid());
+#else
+  return 1;
+#endif
+}
+
+}  // namespace
+
+void setEnabled(bool on) {
+  g_enabled.store(on, std::memory_order_relaxed);
+}
+
+bool enabled() {
+  return g_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t nowNs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+void setThreadName(const char* name) {
+  ThreadRing* ring = localRing();
+  if (!ring || !name) return;
+  std::lock_guard<std::mutex> lock(registry().mtx);
+  ring->name = name;
+}
+
+void complete(const char* category, const char* name, uint64_t startNs, uint64_t durNs) {
+  push(Record{startNs, durNs, category, name, 0.0, Phase::Complete});
+}
+
+void instant(const char* category, const char* name) {
+  push(Record{nowNs(), 0, category, name, 0.0, Phase::Instant});
+}
+
+void counter(const char* category, const char* name, double value) {
+  push(Record{nowNs(), 0, category, name, value, Phase::Counter});
+}
+
+void dumpChromeJson(std::ostream& out) {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mtx);
+  const long pid = processId();
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  auto sep = [&] {
+    if (!first) out << ",\n";
+    first = false;
+  };
+
+  for (const auto& ring : reg.rings) {
+    if (ring->head.load(std::memory_order_acquire) == 0) continue;
+
+    sep();
+    out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid
+        << ",\"tid\":" << ring->tid << ",\"args\":{\"name\":";
+    writeJsonString(out, ring->name.c_str());
+    out << "}}";
+
+    for (const Record& r : snapshot(*ring)) {
+      sep();
+      out << "{\"name\":";
+      writeJsonString(out, r.name);
+      out << ",\"cat\":";
+      writeJsonString(out, r.category);
+      out << ",\"pid\":" << pid << ",\"tid\":" << ring->tid << ",\"ts\":";
+      writeMicros(out, r.tsNs);
+      switch (r.phase) {
+        case Phase::Complete:
+          out << ",\"ph\":\"X\",\"dur\":";
+          writeMicros(out, r.durNs);
+          break;
+        case Phase::Instant:
+          out << ",\"ph\":\"i\",\"s\":\"t\"";
+          break;
+        case Phase::Counter:
+          out << ",\"ph\":\"C\",\"args\":{\"value\":";
+          writeNumber(out, r.value);
+          out << "}";
+          break;
+      }
+      out << "}";
+    }
+  }
+
+  // A partial trace should be recognisable as such: report threads that ran
+  // without a ring and the events they lost, both in the timeline and as
+  // top-level metadata.
+  const uint64_t starved = g_starvedThreads.load(std::memory_order_relaxed);
+  const uint64_t dropped = g_droppedEvents.load(std::memory_order_relaxed);
+  sep();
+  out << "{\"name\":\"trace.dropped\",\"cat\":\"trace\",\"pid\":" << pid
+      << ",\"tid\":0,\"ts\":";
+  writeMicros(out, nowNs());
+  out << ",\"ph\":\"C\",\"args\":{\"threads\":" << starved << ",\"events\":" << dropped << "}}";
+  out << "],\"otherData\":{\"droppedThreads\":" << starved << ",\"droppedEvents\":" << dropped
+      << ",\"maxThreadRings\":" << kMaxRings << "}}\n";
+}
+
+bool dumpChromeJson(const std::string& path) {
+  std::ofstream f(path, std::ios::out | std::ios::trunc);
+  if (!f) return false;
+  dumpChromeJson(f);
+  return static_cast<bool>(f);
+}
+
+}  // namespace trace
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+
+// Low-overhead trace-event recorder.
+//
+// Every thread that emits an event gets its own fixed-size ring buffer of
+// binary records, so recording is a couple of relaxed/release stores with no
+// locks and no formatting. Names and categories must be string literals (only
+// the pointer is stored). The rings are turned into Chrome/Perfetto JSON only
+// when dumpChromeJson() is called.
+//
+// Levels compile out: events above STREAMMATRIX_TRACE_LEVEL are discarded at
+// compile time. 0 = off, 1 = coarse (bus dispatch, UI paints, meter updates),
+// 2 = fine (per-buffer pad probes).
+
+#ifndef STREAMMATRIX_TRACE_LEVEL
+#define STREAMMATRIX_TRACE_LEVEL 1
+#endif
+
+namespace trace {
+
+enum Level : int { kOff = 0, kCoarse = 1, kFine = 2 };
+
+constexpr bool compiledIn(int level) {
+  return level != kOff && level <= STREAMMATRIX_TRACE_LEVEL;
+}
+
+enum class Phase : uint8_t { Complete, Instant, Counter };
+
+struct Record {
+  uint64_t tsNs;
+  uint64_t durNs;
+  const char* category;
+  const char* name;
+  double value;
+  Phase phase;
+};
+
+// Runtime switch on top of the compile-time level; recording starts enabled.
+void setEnabled(bool on);
+bool enabled();
+
+uint64_t nowNs();
+
+// Names the calling thread in the exported timeline. Optional; defaults to the
+// OS thread name where available.
+void setThreadName(const char* name);
+
+void complete(const char* category, const char* name, uint64_t startNs, uint64_t durNs);
+void instant(const char* category, const char* name);
+void counter(const char* category, const char* name, double value);
+
+// Writes every thread's ring as a Chrome trace-event JSON document, loadable
+// in ui.perfetto.dev or chrome://tracing. Safe to call while other threads
+// keep recording; records overwritten mid-copy are dropped. Events lost
+// because every ring was taken are reported as a "trace.dropped" counter and
+// in "otherData".
+void dumpChromeJson(std::ostream& out);
+bool dumpChromeJson(const std::string& path);
+
+template <int L>
+class Scope {
+public:
+  Scope(const char* category, const char* name)
+      : category_(category), name_(name), startNs_(enabled() ? nowNs() : 0) {}
+  ~Scope() {
+    if (startNs_) complete(category_, name_, startNs_, nowNs() - startNs_);
+  }
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  const char* category_;
+  const char* name_;
+  uint64_t startNs_;
+};
+
+struct NullScope {
+  NullScope(const char*, const char*) {}
+};
+
+template <int L>
+using ScopeFor = std::conditional_t<compiledIn(L), Scope<L>, NullScope>;
+
+}  // namespace trace
+
+#define SM_TRACE_CAT2(a, b) a##b
+#define SM_TRACE_CAT(a, b) SM_TRACE_CAT2(a, b)
+
+#define SM_TRACE_SCOPE(level, category, name) \
+  ::trace::ScopeFor<(level)> SM_TRACE_CAT(smTraceScope_, __LINE__)((category), (name))
+
+#define SM_TRACE_INSTANT(level, category, name)                                \
+  do {                                                                         \
+    if constexpr (::trace::compiledIn(level)) {                                \
+      if (::trace::enabled()) ::trace::instant((category), (name));            \
+    }                                                                          \
+  } while (0)
+
+#define SM_TRACE_COUNTER(level, category, name, value)                         \
+  do {                                                                         \
+    if constexpr (::trace::compiledIn(level)) {                                \
+      if (::trace::enabled()) ::trace::counter((category), (name), (value));   \
+    }                                                                          \
+  } while (0)